@@ -0,0 +1,576 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "leptjson.h"
+
+#define BENCH_RUNS 5
+
+typedef struct {
+    char* s;
+    size_t len, capacity;
+}buffer;
+
+static void append(buffer* b, const char* s) {
+    size_t len = strlen(s);
+    if (b->len + len + 1 > b->capacity) {
+        while (b->len + len + 1 > b->capacity)
+            b->capacity = b->capacity == 0 ? 4096 : b->capacity * 2;
+        b->s = (char*)realloc(b->s, b->capacity);
+    }
+    memcpy(b->s + b->len, s, len + 1);
+    b->len += len;
+}
+
+/* An array of user records, either pretty-printed or minified. */
+static char* generate(size_t size, int pretty) {
+    static const char* fields[][2] = {
+        { "id",     "%lu" },
+        { "name",   "\"user_%lu\"" },
+        { "email",  "\"user_%lu@example.com\"" },
+        { "score",  "%lu.25" },
+        { "active", "true" },
+        { "tags",   "[\"alpha\", \"beta\", \"gamma\"]" },
+        { "bio",    "\"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor (#%lu).\"" }
+    };
+    const char* indent = pretty ? "\n        " : "";
+    buffer b = { NULL, 0, 0 };
+    unsigned long i;
+    size_t j;
+    char tmp[256];
+    append(&b, "[");
+    for (i = 0; b.len < size; i++) {
+        append(&b, i > 0 ? "," : "");
+        append(&b, pretty ? "\n    {" : "{");
+        for (j = 0; j < sizeof(fields) / sizeof(fields[0]); j++) {
+            sprintf(tmp, "%s%s\"%s\":%s", j > 0 ? "," : "", indent, fields[j][0], pretty ? " " : "");
+            append(&b, tmp);
+            sprintf(tmp, fields[j][1], i);
+            append(&b, tmp);
+        }
+        append(&b, pretty ? "\n    }" : "}");
+    }
+    append(&b, pretty ? "\n]\n" : "]");
+    return b.s;
+}
+
+/* An array of long, escape-free log lines. */
+static char* generate_logs(size_t size) {
+    buffer b = { NULL, 0, 0 };
+    unsigned long i;
+    char tmp[256];
+    append(&b, "[");
+    for (i = 0; b.len < size; i++) {
+        sprintf(tmp, "%s\n    \"2018-06-02T12:00:00Z INFO GET /api/v1/users/%lu status=200 latency_ms=%lu "
+            "agent=Mozilla/5.0 (X11; Linux x86_64)\"", i > 0 ? "," : "", i, i % 100);
+        append(&b, tmp);
+    }
+    append(&b, "\n]\n");
+    return b.s;
+}
+
+/* A flat array of prices and counters. */
+static char* generate_numbers(size_t size) {
+    buffer b = { NULL, 0, 0 };
+    unsigned long i;
+    char tmp[64];
+    append(&b, "[");
+    for (i = 0; b.len < size; i++) {
+        if (i % 2)
+            sprintf(tmp, "%s%lu", i > 1 ? "," : "", i * 7919 % 1000003);
+        else
+            sprintf(tmp, "%s%lu.%02lu", i > 0 ? "," : "", i % 10000, i % 97);
+        append(&b, tmp);
+    }
+    append(&b, "]");
+    return b.s;
+}
+
+/* Best of BENCH_RUNS, in seconds. */
+static double time_parse(int (*parse)(lept_value*, const char*), const char* json) {
+    double best = 0.0;
+    int i;
+    for (i = 0; i < BENCH_RUNS; i++) {
+        lept_value v;
+        clock_t start;
+        double t;
+        lept_init(&v);
+        start = clock();
+        if (parse(&v, json) != LEPT_PARSE_OK) {
+            fprintf(stderr, "parse error\n");
+            exit(1);
+        }
+        t = (double)(clock() - start) / CLOCKS_PER_SEC;
+        lept_free(&v);
+        if (i == 0 || t < best)
+            best = t;
+    }
+    return best;
+}
+
+/* Best of BENCH_RUNS for parsing and freeing, in seconds; d is NULL for a lept_value. */
+static double time_parse_free(lept_document* d, const char* json) {
+    double best = 0.0;
+    int i;
+    for (i = 0; i < BENCH_RUNS; i++) {
+        lept_value v;
+        clock_t start = clock();
+        double t;
+        if (d != NULL) {
+            lept_document_parse(d, json);
+            lept_document_free(d);
+        }
+        else {
+            lept_init(&v);
+            lept_parse(&v, json);
+            lept_free(&v);
+        }
+        t = (double)(clock() - start) / CLOCKS_PER_SEC;
+        if (i == 0 || t < best)
+            best = t;
+    }
+    return best;
+}
+
+/* As time_parse_free, on a fresh copy of json each run. */
+static double time_parse_insitu(lept_document* d, const char* json) {
+    size_t size = strlen(json) + 1;
+    char* copy = (char*)malloc(size);
+    double best = 0.0;
+    int i;
+    for (i = 0; i < BENCH_RUNS; i++) {
+        clock_t start;
+        double t;
+        memcpy(copy, json, size);
+        start = clock();
+        lept_document_parse_insitu(d, copy);
+        lept_document_free(d);
+        t = (double)(clock() - start) / CLOCKS_PER_SEC;
+        if (i == 0 || t < best)
+            best = t;
+    }
+    free(copy);
+    return best;
+}
+
+static void bench_parse(const char* name, char* json) {
+    double gb = strlen(json) / 1e9;
+    double scalar = time_parse(lept_parse, json);
+    double indexed = time_parse(lept_parse_indexed, json);
+    double value, document, views, insitu;
+    lept_document d;
+    printf("%-10s %7.1f MB  lept_parse %6.3f GB/s  lept_parse_indexed %6.3f GB/s  (%.2fx)\n",
+        name, gb * 1e3, gb / scalar, gb / indexed, scalar / indexed);
+    lept_document_init(&d);
+    value = time_parse_free(NULL, json);
+    document = time_parse_free(&d, json);
+    printf("%-10s %7s     parse+free %6.3f GB/s  lept_document       %6.3f GB/s  (%.2fx)\n",
+        "", "", gb / value, gb / document, value / document);
+    d.views = 1;
+    views = time_parse_free(&d, json);
+    printf("%-10s %7s     parse+free %6.3f GB/s  lept_document views %6.3f GB/s  (%.2fx)\n",
+        "", "", gb / value, gb / views, value / views);
+    insitu = time_parse_insitu(&d, json);
+    printf("%-10s %7s     parse+free %6.3f GB/s  lept_document insitu %5.3f GB/s  (%.2fx)\n",
+        "", "", gb / value, gb / insitu, value / insitu);
+    free(json);
+}
+
+/* Reading a file into a buffer first against parsing from its mapping, both into view documents. */
+static void bench_file(const char* name, char* json) {
+    static const char path[] = "lept_bench.json";
+    size_t size = strlen(json);
+    lept_document d;
+    FILE* f = fopen(path, "wb");
+    clock_t start;
+    double buffered, mapped;
+    char* buffer;
+    fwrite(json, 1, size, f);
+    fclose(f);
+    free(json);
+    lept_document_init(&d);
+    d.views = 1;
+    start = clock();
+    buffer = (char*)malloc(size + 1);
+    f = fopen(path, "rb");
+    buffer[fread(buffer, 1, size, f)] = '\0';
+    fclose(f);
+    lept_document_parse(&d, buffer);
+    lept_document_free(&d);
+    free(buffer);
+    buffered = (double)(clock() - start) / CLOCKS_PER_SEC;
+    start = clock();
+    lept_document_parse_file(&d, path);
+    lept_document_free(&d);
+    mapped = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("%-10s %7.1f MB  fread+parse %5.3f GB/s  lept_document_parse_file %5.3f GB/s  (%.2fx)\n",
+        name, size / 1e6, size / 1e9 / buffered, size / 1e9 / mapped, buffered / mapped);
+    remove(path);
+}
+
+/* Many small messages, as a server would see them: one-shot calls against a reused lept_parser. */
+static void bench_small(size_t count) {
+    char* json = generate(200, 0);
+    lept_parser p;
+    lept_value v;
+    size_t i;
+    clock_t start;
+    double once, reused;
+    lept_init(&v);
+    start = clock();
+    for (i = 0; i < count; i++) {
+        lept_parse(&v, json);
+        lept_free(&v);
+    }
+    once = (double)(clock() - start) / CLOCKS_PER_SEC;
+    lept_parser_init(&p);
+    start = clock();
+    for (i = 0; i < count; i++) {
+        lept_parser_parse(&p, &v, json);
+        lept_free(&v);
+    }
+    reused = (double)(clock() - start) / CLOCKS_PER_SEC;
+    lept_parser_free(&p);
+    printf("small      %5lu B     lept_parse %6.0f ns  lept_parser_parse   %6.0f ns  (%.2fx)\n",
+        (unsigned long)strlen(json), once * 1e9 / count, reused * 1e9 / count, once / reused);
+    free(json);
+}
+
+/* Many small messages with one schema of long keys, parsed with and without a lept_intern. */
+static void bench_intern(size_t count) {
+    static const char json[] = "{\"event_timestamp_utc\":1528000000,\"session_identifier\":\"a1\","
+        "\"request_latency_ms\":12,\"response_status_code\":200,\"client_user_agent\":\"curl\"}";
+    lept_parser p;
+    lept_value v;
+    size_t i, pass;
+    clock_t start;
+    double t[2];
+    lept_init(&v);
+    lept_parser_init(&p);
+    for (pass = 0; pass < 2; pass++) {
+        p.intern = pass ? lept_intern_new(NULL) : NULL;
+        start = clock();
+        for (i = 0; i < count; i++) {
+            lept_parser_parse(&p, &v, json);
+            lept_free(&v);
+        }
+        t[pass] = (double)(clock() - start) / CLOCKS_PER_SEC;
+        lept_intern_free(p.intern);
+    }
+    lept_parser_free(&p);
+    printf("intern     %5lu B     copied keys %6.0f ns  pooled keys %6.0f ns  (%.2fx)\n",
+        (unsigned long)strlen(json), t[0] * 1e9 / count, t[1] * 1e9 / count, t[0] / t[1]);
+}
+
+static int count_number(void* user, const lept_value* n) {
+    (void)n;
+    ++*(size_t*)user;
+    return 1;
+}
+
+/* Counting the numbers of a document with SAX events against building and walking it. */
+static void bench_sax(const char* name, char* json) {
+    lept_handler h = { NULL, NULL, count_number, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+    double gb = strlen(json) / 1e9, dom = 0.0, sax = 0.0;
+    size_t count = 0;
+    int i;
+    h.user = &count;
+    for (i = 0; i < BENCH_RUNS; i++) {
+        lept_value v;
+        clock_t start = clock();
+        double t;
+        lept_init(&v);
+        lept_parse(&v, json);
+        lept_free(&v);
+        t = (double)(clock() - start) / CLOCKS_PER_SEC;
+        if (i == 0 || t < dom)
+            dom = t;
+        start = clock();
+        lept_parse_sax(&h, json);
+        t = (double)(clock() - start) / CLOCKS_PER_SEC;
+        if (i == 0 || t < sax)
+            sax = t;
+    }
+    printf("%-10s %7.1f MB  parse+free %6.3f GB/s  lept_parse_sax      %6.3f GB/s  (%.2fx)\n",
+        name, gb * 1e3, gb / dom, gb / sax, dom / sax);
+    free(json);
+}
+
+/* Copying, comparing and freeing arrays and objects nested depth deep, a million levels in all. */
+static void bench_deep(size_t depth) {
+    lept_value v1, v2, *e = &v1;
+    size_t i, runs = 1000000 / depth;
+    clock_t start;
+    double copied = 0.0, compared = 0.0, freed = 0.0;
+    lept_init(&v1);
+    lept_init(&v2);
+    for (i = 0; i < depth; i++)
+        if (i % 2) {
+            lept_set_object(e, 0);
+            e = lept_set_object_value(e, "a", 1);
+        }
+        else {
+            lept_set_array(e, 0);
+            e = lept_pushback_array_element(e);
+        }
+    for (i = 0; i < runs; i++) {
+        start = clock();
+        lept_copy(&v2, &v1);
+        copied += (double)(clock() - start) / CLOCKS_PER_SEC;
+        start = clock();
+        if (!lept_is_equal(&v1, &v2)) {
+            fprintf(stderr, "copy differs\n");
+            exit(1);
+        }
+        compared += (double)(clock() - start) / CLOCKS_PER_SEC;
+        start = clock();
+        lept_free(&v2);
+        freed += (double)(clock() - start) / CLOCKS_PER_SEC;
+    }
+    printf("deep     %7lu levels  lept_copy %5.1f ns  lept_is_equal %5.1f ns  lept_free %5.1f ns  (per level)\n",
+        (unsigned long)depth, copied * 1e9 / 1e6, compared * 1e9 / 1e6, freed * 1e9 / 1e6);
+    lept_free(&v1);
+}
+
+static void bench_stringify(const char* name, char* json) {
+    lept_value v;
+    double best = 0.0, gb;
+    size_t length = 0;
+    int i;
+    lept_init(&v);
+    if (lept_parse(&v, json) != LEPT_PARSE_OK) {
+        fprintf(stderr, "parse error\n");
+        exit(1);
+    }
+    for (i = 0; i < BENCH_RUNS; i++) {
+        clock_t start = clock();
+        double t;
+        free(lept_stringify(&v, &length));
+        t = (double)(clock() - start) / CLOCKS_PER_SEC;
+        if (i == 0 || t < best)
+            best = t;
+    }
+    gb = length / 1e9;
+    printf("%-10s %7.1f MB  lept_stringify %6.3f GB/s\n", name, gb * 1e3, gb / best);
+    lept_free(&v);
+    free(json);
+}
+
+/* Snapshots of a config-sized tree: lept_copy() node by node, lept_document_copy() into one block. */
+static void bench_copy(size_t size, size_t count) {
+    char* json = generate(size, 0);
+    lept_value v, v2;
+    lept_document d;
+    size_t i;
+    clock_t start;
+    double heap, block;
+    lept_init(&v);
+    lept_init(&v2);
+    lept_document_init(&d);
+    lept_parse(&v, json);
+    start = clock();
+    for (i = 0; i < count; i++) {
+        lept_copy(&v2, &v);
+        lept_free(&v2);
+    }
+    heap = (double)(clock() - start) / CLOCKS_PER_SEC;
+    start = clock();
+    for (i = 0; i < count; i++) {
+        lept_document_copy(&d, &v);
+        lept_document_free(&d);
+    }
+    block = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("copy     %7lu B     lept_copy %9.0f ns  lept_document_copy %9.0f ns  (%.2fx)\n",
+        (unsigned long)strlen(json), heap * 1e9 / count, block * 1e9 / count, heap / block);
+    lept_free(&v);
+    free(json);
+}
+
+/* A copy per request that changes one field: lept_copy() against lept_share(). */
+static void bench_share(size_t size, size_t count) {
+    char* json = generate(size, 0);
+    lept_value v, w;
+    size_t i, pass;
+    clock_t start;
+    double t[2];
+    lept_init(&v);
+    lept_init(&w);
+    lept_parse(&v, json);
+    for (pass = 0; pass < 2; pass++) {
+        start = clock();
+        for (i = 0; i < count; i++) {
+            if (pass)
+                lept_share(&w, &v);
+            else
+                lept_copy(&w, &v);
+            lept_set_number(lept_find_object_value(lept_get_array_element(&w, i % lept_get_array_size(&w)), "score", 5), 1.0);
+            lept_free(&w);
+        }
+        t[pass] = (double)(clock() - start) / CLOCKS_PER_SEC;
+    }
+    printf("share    %7lu B     lept_copy %9.0f ns  lept_share         %9.0f ns  (%.2fx)\n",
+        (unsigned long)strlen(json), t[0] * 1e9 / count, t[1] * 1e9 / count, t[0] / t[1]);
+    lept_free(&v);
+    free(json);
+}
+
+/* Compares two wide objects built in opposite orders. */
+static void bench_equal(size_t width) {
+    lept_value o1, o2;
+    char key[32];
+    size_t i, runs = 10000000 / width, equal = 0;
+    clock_t start;
+    double t;
+    lept_init(&o1);
+    lept_init(&o2);
+    lept_set_object(&o1, 0);
+    lept_set_object(&o2, 0);
+    for (i = 0; i < width; i++) {
+        sprintf(key, "field_%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(&o1, key, strlen(key)), (double)i);
+        sprintf(key, "field_%lu", (unsigned long)(width - 1 - i));
+        lept_set_number(lept_set_object_value(&o2, key, strlen(key)), (double)(width - 1 - i));
+    }
+    start = clock();
+    for (i = 0; i < runs; i++)
+        equal += lept_is_equal(&o1, &o2);
+    t = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("equal    %7lu keys  %6.1f ns/member\n", (unsigned long)width, t * 1e9 / equal / width);
+    lept_free(&o1);
+    lept_free(&o2);
+}
+
+/* Hashes a parsed tree, against stringifying it to hash the text. */
+static void bench_hash(const char* name, char* json) {
+    lept_value v;
+    size_t size = strlen(json), length;
+    clock_t start;
+    double hashed, stringified;
+    uint64_t h;
+    char* s;
+    lept_init(&v);
+    lept_parse(&v, json);
+    start = clock();
+    h = lept_hash(&v);
+    hashed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    start = clock();
+    s = lept_stringify(&v, &length);
+    stringified = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("%-10s %7.1f MB  lept_hash %5.3f GB/s  lept_stringify %5.3f GB/s  (%.2fx, %08lx)\n",
+        name, size / 1e6, size / 1e9 / hashed, size / 1e9 / stringified, stringified / hashed, (unsigned long)(h & 0xFFFFFFFF));
+    free(s);
+    lept_free(&v);
+    free(json);
+}
+
+/* Inserts and erases 1000 elements at the front of a large array, one at a time and as one range. */
+static void bench_array_range(size_t size) {
+    lept_value a;
+    size_t i, n = 1000;
+    clock_t start;
+    double single, range;
+    lept_init(&a);
+    lept_set_array(&a, 0);
+    lept_insert_array_elements(&a, 0, size);
+    start = clock();
+    for (i = 0; i < n; i++)
+        lept_set_number(lept_insert_array_element(&a, 0), (double)i);
+    for (i = 0; i < n; i++)
+        lept_erase_array_element(&a, 0, 1);
+    single = (double)(clock() - start) / CLOCKS_PER_SEC;
+    start = clock();
+    lept_insert_array_elements(&a, 0, n);
+    lept_erase_array_element(&a, 0, n);
+    range = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("range    %7lu elems one at a time %9.0f us  as a range         %9.0f us  (%.0fx)\n",
+        (unsigned long)size, single * 1e6, range * 1e6, single / range);
+    lept_free(&a);
+}
+
+/* Looks up every key of a wide object, repeatedly. */
+static void bench_lookup(size_t width) {
+    lept_value o;
+    char key[32];
+    size_t i, found = 0;
+    int r;
+    clock_t start;
+    double t;
+    lept_init(&o);
+    lept_set_object(&o, 0);
+    for (i = 0; i < width; i++) {
+        sprintf(key, "field_%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(&o, key, strlen(key)), (double)i);
+    }
+    start = clock();
+    for (r = 0; r < 100; r++)
+        for (i = 0; i < width; i++) {
+            sprintf(key, "field_%lu", (unsigned long)i);
+            found += lept_find_object_value(&o, key, strlen(key)) != NULL;
+        }
+    t = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("lookup     %5lu keys  %6.1f ns/lookup\n", (unsigned long)width, t * 1e9 / found);
+    lept_free(&o);
+}
+
+/* Removes the members of a wide object one at a time and puts them back, in order and by swapping. */
+static void bench_object_remove(size_t width) {
+    lept_value o;
+    char key[32];
+    size_t i, n = width < 1000 ? width : 1000;
+    clock_t start;
+    double ordered, swapped;
+    lept_init(&o);
+    lept_set_object(&o, 0);
+    for (i = 0; i < width; i++) {
+        sprintf(key, "field_%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(&o, key, strlen(key)), (double)i);
+    }
+    start = clock();
+    for (i = 0; i < n; i++) {
+        lept_remove_object_value(&o, 0);
+        sprintf(key, "field_%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(&o, key, strlen(key)), (double)i);
+    }
+    ordered = (double)(clock() - start) / CLOCKS_PER_SEC;
+    start = clock();
+    for (i = 0; i < n; i++) {
+        lept_swap_remove_object_value(&o, 0);
+        sprintf(key, "field_%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(&o, key, strlen(key)), (double)i);
+    }
+    swapped = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("remove   %7lu keys  in order %8.1f ns/member  swapped %6.1f ns/member\n",
+        (unsigned long)width, ordered * 1e9 / n, swapped * 1e9 / n);
+    lept_free(&o);
+}
+
+int main() {
+    bench_parse("pretty", generate(64 << 20, 1));
+    bench_parse("minified", generate(64 << 20, 0));
+    bench_parse("logs", generate_logs(64 << 20));
+    bench_parse("numbers", generate_numbers(64 << 20));
+    bench_small(1000000);
+    bench_intern(1000000);
+    bench_file("file", generate_logs(64 << 20));
+    bench_sax("sax", generate(64 << 20, 0));
+    bench_deep(100);
+    bench_deep(10000);
+    bench_deep(1000000);
+    bench_copy(2000, 100000);
+    bench_copy(64 << 10, 5000);
+    bench_share(64 << 10, 5000);
+    bench_stringify("numbers", generate_numbers(64 << 20));
+    bench_hash("hash", generate(64 << 20, 0));
+    bench_hash("logs", generate_logs(64 << 20));
+    bench_lookup(8);
+    bench_lookup(1000);
+    bench_lookup(10000);
+    bench_equal(8);
+    bench_equal(1000);
+    bench_equal(100000);
+    bench_array_range(100000);
+    bench_object_remove(8);
+    bench_object_remove(1000);
+    bench_object_remove(100000);
+    return 0;
+}
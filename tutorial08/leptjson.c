@@ -2,13 +2,60 @@
 #define _CRTDBG_MAP_ALLOC
 #include <crtdbg.h>
 #endif
+#if !defined(_DEFAULT_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+#define _DEFAULT_SOURCE /* mmap() flags and madvise() despite -ansi */
+#endif
 #include "leptjson.h"
 #include <assert.h>  /* assert() */
-#include <errno.h>   /* errno, ERANGE */
+#include <limits.h>  /* UINT_MAX */
 #include <math.h>    /* HUGE_VAL */
+#include <stdint.h>  /* uint64_t */
 #include <stdio.h>   /* sprintf() */
-#include <stdlib.h>  /* NULL, malloc(), realloc(), free(), strtod() */
+#include <stdlib.h>  /* NULL, malloc(), realloc(), free() */
 #include <string.h>  /* memcpy() */
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>     /* open() */
+#include <sys/mman.h>  /* mmap(), madvise() */
+#include <sys/stat.h>  /* fstat() */
+#include <unistd.h>    /* close() */
+#include <pthread.h>   /* pthread_mutex_lock() */
+#define LEPT_MMAP
+#define LEPT_LOCK               pthread_mutex_t
+#define LEPT_LOCK_INIT(l)       pthread_mutex_init(l, NULL)
+#define LEPT_LOCK_ACQUIRE(l)    pthread_mutex_lock(l)
+#define LEPT_LOCK_RELEASE(l)    pthread_mutex_unlock(l)
+#define LEPT_LOCK_FREE(l)       pthread_mutex_destroy(l)
+#elif defined(_WIN32)
+#include <windows.h>   /* EnterCriticalSection() */
+#define LEPT_LOCK               CRITICAL_SECTION
+#define LEPT_LOCK_INIT(l)       InitializeCriticalSection(l)
+#define LEPT_LOCK_ACQUIRE(l)    EnterCriticalSection(l)
+#define LEPT_LOCK_RELEASE(l)    LeaveCriticalSection(l)
+#define LEPT_LOCK_FREE(l)       DeleteCriticalSection(l)
+#else
+#define LEPT_LOCK               int  /* no threads to guard against */
+#define LEPT_LOCK_INIT(l)       (void)(*(l) = 0)
+#define LEPT_LOCK_ACQUIRE(l)    (void)(l)
+#define LEPT_LOCK_RELEASE(l)    (void)(l)
+#define LEPT_LOCK_FREE(l)       (void)(l)
+#endif
+
+#if defined(__GNUC__)
+typedef size_t lept_refcount;
+#define LEPT_REF_INC(r)         __atomic_add_fetch(r, 1, __ATOMIC_RELAXED)
+#define LEPT_REF_DEC(r)         __atomic_sub_fetch(r, 1, __ATOMIC_ACQ_REL)
+#define LEPT_REF_GET(r)         __atomic_load_n(r, __ATOMIC_ACQUIRE)
+#elif defined(_WIN32)
+typedef LONG64 lept_refcount;
+#define LEPT_REF_INC(r)         InterlockedIncrement64(r)
+#define LEPT_REF_DEC(r)         InterlockedDecrement64(r)
+#define LEPT_REF_GET(r)         InterlockedCompareExchange64(r, 0, 0)
+#else
+typedef size_t lept_refcount;   /* no atomics known: shared values stay on one thread */
+#define LEPT_REF_INC(r)         (++*(r))
+#define LEPT_REF_DEC(r)         (--*(r))
+#define LEPT_REF_GET(r)         (*(r))
+#endif
 
 #ifndef LEPT_PARSE_STACK_INIT_SIZE
 #define LEPT_PARSE_STACK_INIT_SIZE 256
@@ -18,27 +65,165 @@
 #define LEPT_PARSE_STRINGIFY_INIT_SIZE 256
 #endif
 
+#ifndef LEPT_OBJECT_HASH_MIN
+#define LEPT_OBJECT_HASH_MIN 16
+#endif
+
+#ifndef LEPT_DOCUMENT_CHUNK_MIN
+#define LEPT_DOCUMENT_CHUNK_MIN 4096
+#endif
+
+#ifndef LEPT_DOCUMENT_CHUNK_MAX
+#define LEPT_DOCUMENT_CHUNK_MAX (1 << 20)
+#endif
+
 #define EXPECT(c, ch)       do { assert(*c->json == (ch)); c->json++; } while(0)
 #define ISDIGIT(ch)         ((ch) >= '0' && (ch) <= '9')
 #define ISDIGIT1TO9(ch)     ((ch) >= '1' && (ch) <= '9')
+#define ISWS(ch)            ((ch) == ' ' || (ch) == '\t' || (ch) == '\n' || (ch) == '\r')
+#define PEEK(c, p)          ((p) < (c)->end ? *(p) : '\0')
 #define PUTC(c, ch)         do { *(char*)lept_context_push(c, sizeof(char)) = (ch); } while(0)
 #define PUTS(c, s, len)     memcpy(lept_context_push(c, len), s, len)
 
+#define LEPT_KIND(v)        ((lept_number_kind)((v)->flags & 3u))  /* a number's; strings reuse the bits */
+#define LEPT_BORROWED       4u  /* flags: the value belongs to a lept_document */
+#define LEPT_OWNED(v)       (!((v)->flags & LEPT_BORROWED))
+#define LEPT_ALIGN(n)       (((n) + 7) & ~(size_t)7)
+#define LEPT_INLINE         1u  /* flags of a string: its bytes are in the value, over u */
+#define LEPT_INLINE_MAX     (offsetof(lept_value, size) - 1)
+#define LEPT_STRING(v)      ((v)->flags & LEPT_INLINE ? (char*)(v) : (v)->u.s)
+#define LEPT_DUPLICATES     1u  /* flags of a hashed object: some key is there twice, and only its first is in the table */
+#define LEPT_SHARED         2u  /* flags of a string, array or object: its storage follows a reference count */
+#define LEPT_IS_SHARED(v)   ((v)->type >= LEPT_STRING && ((v)->flags & LEPT_SHARED))
+#define LEPT_REF_SIZE       LEPT_ALIGN(sizeof(lept_refcount))
+#define LEPT_REFS(p)        ((lept_refcount*)((char*)(p) - LEPT_REF_SIZE))
+#define LEPT_KEY_TAG(m)     ((m)->k.s[LEPT_KEY_INLINE - 1])
+#define LEPT_KEY_HEAP       0   /* key tags: k.p is heap, arena or input memory */
+#define LEPT_KEY_SHORT      1   /* the key is in k.s */
+#define LEPT_KEY_SHARED     2   /* k.p belongs to a lept_intern */
+#define LEPT_KEY(m)         (LEPT_KEY_TAG(m) == LEPT_KEY_SHORT ? (m)->k.s : (m)->k.p)
+
+#define LEPT_MALLOC(a, size)                ((a)->malloc_fn((a)->user, size))
+#define LEPT_REALLOC(a, ptr, old_size, size) ((a)->realloc_fn((a)->user, ptr, old_size, size))
+#define LEPT_FREE(a, ptr, size)             ((a)->free_fn((a)->user, ptr, size))
+
+struct lept_chunk {
+    lept_chunk* next;
+    size_t size, used;
+};
+
+static void* lept_std_malloc(void* user, size_t size) {
+    (void)user;
+    return malloc(size);
+}
+
+static void* lept_std_realloc(void* user, void* ptr, size_t old_size, size_t size) {
+    (void)user;
+    (void)old_size;
+    return realloc(ptr, size);
+}
+
+static void lept_std_free(void* user, void* ptr, size_t size) {
+    (void)user;
+    (void)size;
+    free(ptr);
+}
+
+static const lept_allocator lept_std_allocator = { lept_std_malloc, lept_std_realloc, lept_std_free, NULL };
+
+/* Values do not record their allocator, so everything they own comes from this one. */
+static lept_allocator lept_allocator_default = { lept_std_malloc, lept_std_realloc, lept_std_free, NULL };
+
+void lept_set_allocator(const lept_allocator* a) {
+    lept_allocator_default = a != NULL ? *a : lept_std_allocator;
+}
+
+const lept_allocator* lept_get_allocator(void) {
+    return &lept_allocator_default;
+}
+
+/* Copies s into v, inline when it fits; p is heap or arena memory for a longer one. */
+static void lept_string_store(lept_value* v, const char* s, size_t len, char* p) {
+    if (len <= LEPT_INLINE_MAX) {
+        p = (char*)v;
+        v->flags = LEPT_INLINE;
+    }
+    else {
+        v->u.s = p;
+        v->flags = 0;
+    }
+    if (len > 0)
+        memcpy(p, s, len);
+    p[len] = '\0';
+    v->size = len;
+    v->type = LEPT_STRING;
+}
+
+static void lept_string_init(lept_value* v, const char* s, size_t len) {
+    lept_string_store(v, s, len, len > LEPT_INLINE_MAX ? (char*)LEPT_MALLOC(&lept_allocator_default, len + 1) : NULL);
+}
+
+static void lept_string_free(const lept_value* v) {
+    if (v->flags & LEPT_SHARED) {
+        if (LEPT_REF_DEC(LEPT_REFS(v->u.s)) == 0)
+            LEPT_FREE(&lept_allocator_default, LEPT_REFS(v->u.s), LEPT_REF_SIZE + v->size + 1);
+    }
+    else if (!(v->flags & LEPT_INLINE))
+        LEPT_FREE(&lept_allocator_default, v->u.s, v->size + 1);
+}
+
+/* As lept_string_store(), for the key of m. */
+static void lept_key_store(lept_member* m, const char* key, size_t klen, char* p) {
+    if (klen < LEPT_KEY_INLINE - 1) {
+        p = m->k.s;
+        LEPT_KEY_TAG(m) = LEPT_KEY_SHORT;
+    }
+    else {
+        m->k.p = p;
+        LEPT_KEY_TAG(m) = LEPT_KEY_HEAP;
+    }
+    if (klen > 0)
+        memcpy(p, key, klen);
+    p[klen] = '\0';
+    m->klen = klen;
+}
+
+static void lept_key_init(lept_member* m, const char* key, size_t klen) {
+    lept_key_store(m, key, klen, klen >= LEPT_KEY_INLINE - 1 ? (char*)LEPT_MALLOC(&lept_allocator_default, klen + 1) : NULL);
+}
+
+static void lept_key_free(const lept_member* m) {
+    if (LEPT_KEY_TAG(m) == LEPT_KEY_HEAP)
+        LEPT_FREE(&lept_allocator_default, m->k.p, m->klen + 1);
+}
+
 typedef struct {
     const char* json;
     char* stack;
     size_t size, top;
+    const char* base;       /* start of the input, for structural index offsets */
+    const char* end;        /* end of the input, which need not be null-terminated */
+    const unsigned* index;  /* structural index cursor, NULL for the scalar path */
+    const uint64_t* dirty;  /* bitmap of backslashes and control characters in strings */
+    lept_document* doc;     /* arena for parsed values, NULL for the process-wide allocator */
+    int insitu;             /* strings are decoded over the input, which is writable */
+    const lept_handler* handler;        /* SAX events instead of values, NULL to build values */
+    lept_parser* parser;    /* for its pool of long keys, NULL to copy each one */
+    size_t frame;           /* innermost open array or object on the stack */
+    size_t depth, max_depth;
+    const lept_allocator* allocator;    /* for the stack */
 }lept_context;
 
 static void* lept_context_push(lept_context* c, size_t size) {
     void* ret;
     assert(size > 0);
     if (c->top + size >= c->size) {
+        size_t old_size = c->size;
         if (c->size == 0)
             c->size = LEPT_PARSE_STACK_INIT_SIZE;
         while (c->top + size >= c->size)
             c->size += c->size >> 1;  /* c->size * 1.5 */
-        c->stack = (char*)realloc(c->stack, c->size);
+        c->stack = (char*)LEPT_REALLOC(c->allocator, c->stack, old_size, c->size);
     }
     ret = c->stack + c->top;
     c->top += size;
@@ -50,9 +235,131 @@ static void* lept_context_pop(lept_context* c, size_t size) {
     return c->stack + (c->top -= size);
 }
 
+static const lept_allocator* lept_document_allocator(const lept_document* d) {
+    return d->allocator != NULL ? d->allocator : &lept_allocator_default;
+}
+
+/* Bump allocation from the newest chunk; chunks double in size up to LEPT_DOCUMENT_CHUNK_MAX. */
+static void* lept_document_alloc(lept_document* d, size_t size) {
+    lept_chunk* k = d->chunks;
+    char* ret;
+    size = LEPT_ALIGN(size);
+    if (k == NULL || k->size - k->used < size) {
+        size_t n = k == NULL ? LEPT_DOCUMENT_CHUNK_MIN : k->size < LEPT_DOCUMENT_CHUNK_MAX ? k->size * 2 : k->size;
+        if (n < size)
+            n = size;
+        k = (lept_chunk*)LEPT_MALLOC(lept_document_allocator(d), LEPT_ALIGN(sizeof(lept_chunk)) + n);
+        k->size = n;
+        k->used = 0;
+        if (n == size && d->chunks != NULL) {
+            /* an oversized block gets its own chunk, behind the current one */
+            k->next = d->chunks->next;
+            d->chunks->next = k;
+        }
+        else {
+            k->next = d->chunks;
+            d->chunks = k;
+        }
+    }
+    ret = (char*)k + LEPT_ALIGN(sizeof(lept_chunk)) + k->used;
+    k->used += size;
+    return ret;
+}
+
+/* Starts a chunk of exactly size bytes, for allocations known in advance. */
+static void lept_document_reserve(lept_document* d, size_t size) {
+    lept_chunk* k = (lept_chunk*)LEPT_MALLOC(lept_document_allocator(d), LEPT_ALIGN(sizeof(lept_chunk)) + size);
+    k->size = size;
+    k->used = 0;
+    k->next = d->chunks;
+    d->chunks = k;
+}
+
+/* Maps a file read-only, or reads it into memory where mmap() is not available. */
+static int lept_map_file(const char* path, const lept_allocator* a, void** map, size_t* size) {
+#ifdef LEPT_MMAP
+    struct stat st;
+    int fd, flags = MAP_PRIVATE;
+    (void)a;
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return 0;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size > (size_t)-1) {
+        close(fd);
+        return 0;
+    }
+    *map = NULL;
+    if ((*size = (size_t)st.st_size) > 0) {
+#ifdef MAP_POPULATE
+        flags |= MAP_POPULATE;
+#endif
+        if ((*map = mmap(NULL, *size, PROT_READ, flags, fd, 0)) == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+#ifdef MADV_SEQUENTIAL
+        madvise(*map, *size, MADV_SEQUENTIAL);
+#endif
+    }
+    close(fd);
+    return 1;
+#else
+    FILE* f;
+    long n;
+    if ((f = fopen(path, "rb")) == NULL)
+        return 0;
+    if (fseek(f, 0, SEEK_END) != 0 || (n = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0) {
+        fclose(f);
+        return 0;
+    }
+    *map = NULL;
+    if ((*size = (size_t)n) > 0 && fread(*map = LEPT_MALLOC(a, *size), 1, *size, f) != *size) {
+        LEPT_FREE(a, *map, *size);
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+    return 1;
+#endif
+}
+
+static void lept_unmap_file(const lept_allocator* a, void* map, size_t size) {
+#ifdef LEPT_MMAP
+    (void)a;
+    if (map != NULL)
+        munmap(map, size);
+#else
+    LEPT_FREE(a, map, size);
+#endif
+}
+
+static void* lept_context_alloc(lept_context* c, size_t size) {
+    return c->doc != NULL ? lept_document_alloc(c->doc, size) : LEPT_MALLOC(&lept_allocator_default, size);
+}
+
+/* Drops what was parsed before an error; document memory goes away with its arena. */
+static void lept_context_free(lept_context* c, void* p, size_t size) {
+    if (c->doc == NULL)
+        LEPT_FREE(&lept_allocator_default, p, size);
+}
+
+static void lept_context_discard(lept_context* c, lept_value* v) {
+    if (c->doc == NULL)
+        lept_free(v);
+}
+
 static void lept_parse_whitespace(lept_context* c) {
     const char *p = c->json;
-    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+    if (c->index) {
+        /* only whitespace lies between here and the next indexed token */
+        if (p < c->end && ISWS(*p)) {
+            size_t pos = p - c->base;
+            while (*c->index < pos)
+                c->index++;
+            c->json = c->base + *c->index;
+        }
+        return;
+    }
+    while (p < c->end && ISWS(*p))
         p++;
     c->json = p;
 }
@@ -61,44 +368,667 @@ static int lept_parse_literal(lept_context* c, lept_value* v, const char* litera
     size_t i;
     EXPECT(c, literal[0]);
     for (i = 0; literal[i + 1]; i++)
-        if (c->json[i] != literal[i + 1])
+        if (c->json + i == c->end || c->json[i] != literal[i + 1])
             return LEPT_PARSE_INVALID_VALUE;
     c->json += i;
     v->type = type;
     return LEPT_PARSE_OK;
 }
 
+/*
+ * Decimal to double conversion, correctly rounded.
+ *
+ * lept_parse_number() gathers the first 19 significant digits into a 64-bit
+ * integer w and a decimal exponent q while it checks the grammar. Then:
+ * 1. Clinger's fast path: w <= 2^53 and |q| <= 22 is exact in double arithmetic.
+ * 2. Eisel-Lemire: multiply w by a 128-bit approximation of 5^q, which always
+ *    decides the rounding when w holds all digits.
+ * 3. With more than 19 digits, w and w + 1 bracket the value. If they round
+ *    apart, a big-integer comparison against the midpoint decides.
+ */
+
+#define LEPT_POW5_MIN (-342)
+#define LEPT_POW5_MAX 308
+#define LEPT_DOUBLE_INF ((uint64_t)0x7FF << 52)
+
+/* 5^q normalized to 128 bits (most significant bit set), for q in [LEPT_POW5_MIN, LEPT_POW5_MAX] */
+static const uint32_t lept_pow5_128[][4] = {
+    { 0xeef453d6u, 0x923bd65au, 0x113faa29u, 0x06a13b3fu }, { 0x9558b466u, 0x1b6565f8u, 0x4ac7ca59u, 0xa424c507u },
+    { 0xbaaee17fu, 0xa23ebf76u, 0x5d79bcf0u, 0x0d2df649u }, { 0xe95a99dfu, 0x8ace6f53u, 0xf4d82c2cu, 0x107973dcu },
+    { 0x91d8a02bu, 0xb6c10594u, 0x79071b9bu, 0x8a4be869u }, { 0xb64ec836u, 0xa47146f9u, 0x9748e282u, 0x6cdee284u },
+    { 0xe3e27a44u, 0x4d8d98b7u, 0xfd1b1b23u, 0x08169b25u }, { 0x8e6d8c6au, 0xb0787f72u, 0xfe30f0f5u, 0xe50e20f7u },
+    { 0xb208ef85u, 0x5c969f4fu, 0xbdbd2d33u, 0x5e51a935u }, { 0xde8b2b66u, 0xb3bc4723u, 0xad2c7880u, 0x35e61382u },
+    { 0x8b16fb20u, 0x3055ac76u, 0x4c3bcb50u, 0x21afcc31u }, { 0xaddcb9e8u, 0x3c6b1793u, 0xdf4abe24u, 0x2a1bbf3du },
+    { 0xd953e862u, 0x4b85dd78u, 0xd71d6dadu, 0x34a2af0du }, { 0x87d4713du, 0x6f33aa6bu, 0x8672648cu, 0x40e5ad68u },
+    { 0xa9c98d8cu, 0xcb009506u, 0x680efdafu, 0x511f18c2u }, { 0xd43bf0efu, 0xfdc0ba48u, 0x0212bd1bu, 0x2566def2u },
+    { 0x84a57695u, 0xfe98746du, 0x014bb630u, 0xf7604b57u }, { 0xa5ced43bu, 0x7e3e9188u, 0x419ea3bdu, 0x35385e2du },
+    { 0xcf42894au, 0x5dce35eau, 0x52064cacu, 0x828675b9u }, { 0x818995ceu, 0x7aa0e1b2u, 0x7343efebu, 0xd1940993u },
+    { 0xa1ebfb42u, 0x19491a1fu, 0x1014ebe6u, 0xc5f90bf8u }, { 0xca66fa12u, 0x9f9b60a6u, 0xd41a26e0u, 0x77774ef6u },
+    { 0xfd00b897u, 0x478238d0u, 0x8920b098u, 0x955522b4u }, { 0x9e20735eu, 0x8cb16382u, 0x55b46e5fu, 0x5d5535b0u },
+    { 0xc5a89036u, 0x2fddbc62u, 0xeb2189f7u, 0x34aa831du }, { 0xf712b443u, 0xbbd52b7bu, 0xa5e9ec75u, 0x01d523e4u },
+    { 0x9a6bb0aau, 0x55653b2du, 0x47b233c9u, 0x2125366eu }, { 0xc1069cd4u, 0xeabe89f8u, 0x999ec0bbu, 0x696e840au },
+    { 0xf148440au, 0x256e2c76u, 0xc00670eau, 0x43ca250du }, { 0x96cd2a86u, 0x5764dbcau, 0x38040692u, 0x6a5e5728u },
+    { 0xbc807527u, 0xed3e12bcu, 0xc6050837u, 0x04f5ecf2u }, { 0xeba09271u, 0xe88d976bu, 0xf7864a44u, 0xc633682eu },
+    { 0x93445b87u, 0x31587ea3u, 0x7ab3ee6au, 0xfbe0211du }, { 0xb8157268u, 0xfdae9e4cu, 0x5960ea05u, 0xbad82964u },
+    { 0xe61acf03u, 0x3d1a45dfu, 0x6fb92487u, 0x298e33bdu }, { 0x8fd0c162u, 0x06306babu, 0xa5d3b6d4u, 0x79f8e056u },
+    { 0xb3c4f1bau, 0x87bc8696u, 0x8f48a489u, 0x9877186cu }, { 0xe0b62e29u, 0x29aba83cu, 0x331acdabu, 0xfe94de87u },
+    { 0x8c71dcd9u, 0xba0b4925u, 0x9ff0c08bu, 0x7f1d0b14u }, { 0xaf8e5410u, 0x288e1b6fu, 0x07ecf0aeu, 0x5ee44dd9u },
+    { 0xdb71e914u, 0x32b1a24au, 0xc9e82cd9u, 0xf69d6150u }, { 0x892731acu, 0x9faf056eu, 0xbe311c08u, 0x3a225cd2u },
+    { 0xab70fe17u, 0xc79ac6cau, 0x6dbd630au, 0x48aaf406u }, { 0xd64d3d9du, 0xb981787du, 0x092cbbccu, 0xdad5b108u },
+    { 0x85f04682u, 0x93f0eb4eu, 0x25bbf560u, 0x08c58ea5u }, { 0xa76c5823u, 0x38ed2621u, 0xaf2af2b8u, 0x0af6f24eu },
+    { 0xd1476e2cu, 0x07286faau, 0x1af5af66u, 0x0db4aee1u }, { 0x82cca4dbu, 0x847945cau, 0x50d98d9fu, 0xc890ed4du },
+    { 0xa37fce12u, 0x6597973cu, 0xe50ff107u, 0xbab528a0u }, { 0xcc5fc196u, 0xfefd7d0cu, 0x1e53ed49u, 0xa96272c8u },
+    { 0xff77b1fcu, 0xbebcdc4fu, 0x25e8e89cu, 0x13bb0f7au }, { 0x9faacf3du, 0xf73609b1u, 0x77b19161u, 0x8c54e9acu },
+    { 0xc795830du, 0x75038c1du, 0xd59df5b9u, 0xef6a2417u }, { 0xf97ae3d0u, 0xd2446f25u, 0x4b057328u, 0x6b44ad1du },
+    { 0x9becce62u, 0x836ac577u, 0x4ee367f9u, 0x430aec32u }, { 0xc2e801fbu, 0x244576d5u, 0x229c41f7u, 0x93cda73fu },
+    { 0xf3a20279u, 0xed56d48au, 0x6b435275u, 0x78c1110fu }, { 0x9845418cu, 0x345644d6u, 0x830a1389u, 0x6b78aaa9u },
+    { 0xbe5691efu, 0x416bd60cu, 0x23cc986bu, 0xc656d553u }, { 0xedec366bu, 0x11c6cb8fu, 0x2cbfbe86u, 0xb7ec8aa8u },
+    { 0x94b3a202u, 0xeb1c3f39u, 0x7bf7d714u, 0x32f3d6a9u }, { 0xb9e08a83u, 0xa5e34f07u, 0xdaf5ccd9u, 0x3fb0cc53u },
+    { 0xe858ad24u, 0x8f5c22c9u, 0xd1b3400fu, 0x8f9cff68u }, { 0x91376c36u, 0xd99995beu, 0x23100809u, 0xb9c21fa1u },
+    { 0xb5854744u, 0x8ffffb2du, 0xabd40a0cu, 0x2832a78au }, { 0xe2e69915u, 0xb3fff9f9u, 0x16c90c8fu, 0x323f516cu },
+    { 0x8dd01fadu, 0x907ffc3bu, 0xae3da7d9u, 0x7f6792e3u }, { 0xb1442798u, 0xf49ffb4au, 0x99cd11cfu, 0xdf41779cu },
+    { 0xdd95317fu, 0x31c7fa1du, 0x40405643u, 0xd711d583u }, { 0x8a7d3eefu, 0x7f1cfc52u, 0x482835eau, 0x666b2572u },
+    { 0xad1c8eabu, 0x5ee43b66u, 0xda324365u, 0x0005eecfu }, { 0xd863b256u, 0x369d4a40u, 0x90bed43eu, 0x40076a82u },
+    { 0x873e4f75u, 0xe2224e68u, 0x5a7744a6u, 0xe804a291u }, { 0xa90de353u, 0x5aaae202u, 0x711515d0u, 0xa205cb36u },
+    { 0xd3515c28u, 0x31559a83u, 0x0d5a5b44u, 0xca873e03u }, { 0x8412d999u, 0x1ed58091u, 0xe858790au, 0xfe9486c2u },
+    { 0xa5178fffu, 0x668ae0b6u, 0x626e974du, 0xbe39a872u }, { 0xce5d73ffu, 0x402d98e3u, 0xfb0a3d21u, 0x2dc8128fu },
+    { 0x80fa687fu, 0x881c7f8eu, 0x7ce66634u, 0xbc9d0b99u }, { 0xa139029fu, 0x6a239f72u, 0x1c1fffc1u, 0xebc44e80u },
+    { 0xc9874347u, 0x44ac874eu, 0xa327ffb2u, 0x66b56220u }, { 0xfbe91419u, 0x15d7a922u, 0x4bf1ff9fu, 0x0062baa8u },
+    { 0x9d71ac8fu, 0xada6c9b5u, 0x6f773fc3u, 0x603db4a9u }, { 0xc4ce17b3u, 0x99107c22u, 0xcb550fb4u, 0x384d21d3u },
+    { 0xf6019da0u, 0x7f549b2bu, 0x7e2a53a1u, 0x46606a48u }, { 0x99c10284u, 0x4f94e0fbu, 0x2eda7444u, 0xcbfc426du },
+    { 0xc0314325u, 0x637a1939u, 0xfa911155u, 0xfefb5308u }, { 0xf03d93eeu, 0xbc589f88u, 0x793555abu, 0x7eba27cau },
+    { 0x96267c75u, 0x35b763b5u, 0x4bc1558bu, 0x2f3458deu }, { 0xbbb01b92u, 0x83253ca2u, 0x9eb1aaedu, 0xfb016f16u },
+    { 0xea9c2277u, 0x23ee8bcbu, 0x465e15a9u, 0x79c1cadcu }, { 0x92a1958au, 0x7675175fu, 0x0bfacd89u, 0xec191ec9u },
+    { 0xb749faedu, 0x14125d36u, 0xcef980ecu, 0x671f667bu }, { 0xe51c79a8u, 0x5916f484u, 0x82b7e127u, 0x80e7401au },
+    { 0x8f31cc09u, 0x37ae58d2u, 0xd1b2ecb8u, 0xb0908810u }, { 0xb2fe3f0bu, 0x8599ef07u, 0x861fa7e6u, 0xdcb4aa15u },
+    { 0xdfbdceceu, 0x67006ac9u, 0x67a791e0u, 0x93e1d49au }, { 0x8bd6a141u, 0x006042bdu, 0xe0c8bb2cu, 0x5c6d24e0u },
+    { 0xaecc4991u, 0x4078536du, 0x58fae9f7u, 0x73886e18u }, { 0xda7f5bf5u, 0x90966848u, 0xaf39a475u, 0x506a899eu },
+    { 0x888f9979u, 0x7a5e012du, 0x6d8406c9u, 0x52429603u }, { 0xaab37fd7u, 0xd8f58178u, 0xc8e5087bu, 0xa6d33b83u },
+    { 0xd5605fcdu, 0xcf32e1d6u, 0xfb1e4a9au, 0x90880a64u }, { 0x855c3be0u, 0xa17fcd26u, 0x5cf2eea0u, 0x9a55067fu },
+    { 0xa6b34ad8u, 0xc9dfc06fu, 0xf42faa48u, 0xc0ea481eu }, { 0xd0601d8eu, 0xfc57b08bu, 0xf13b94dau, 0xf124da26u },
+    { 0x823c1279u, 0x5db6ce57u, 0x76c53d08u, 0xd6b70858u }, { 0xa2cb1717u, 0xb52481edu, 0x54768c4bu, 0x0c64ca6eu },
+    { 0xcb7ddcddu, 0xa26da268u, 0xa9942f5du, 0xcf7dfd09u }, { 0xfe5d5415u, 0x0b090b02u, 0xd3f93b35u, 0x435d7c4cu },
+    { 0x9efa548du, 0x26e5a6e1u, 0xc47bc501u, 0x4a1a6dafu }, { 0xc6b8e9b0u, 0x709f109au, 0x359ab641u, 0x9ca1091bu },
+    { 0xf867241cu, 0x8cc6d4c0u, 0xc30163d2u, 0x03c94b62u }, { 0x9b407691u, 0xd7fc44f8u, 0x79e0de63u, 0x425dcf1du },
+    { 0xc2109436u, 0x4dfb5636u, 0x985915fcu, 0x12f542e4u }, { 0xf294b943u, 0xe17a2bc4u, 0x3e6f5b7bu, 0x17b2939du },
+    { 0x979cf3cau, 0x6cec5b5au, 0xa705992cu, 0xeecf9c42u }, { 0xbd8430bdu, 0x08277231u, 0x50c6ff78u, 0x2a838353u },
+    { 0xece53cecu, 0x4a314ebdu, 0xa4f8bf56u, 0x35246428u }, { 0x940f4613u, 0xae5ed136u, 0x871b7795u, 0xe136be99u },
+    { 0xb9131798u, 0x99f68584u, 0x28e2557bu, 0x59846e3fu }, { 0xe757dd7eu, 0xc07426e5u, 0x331aeadau, 0x2fe589cfu },
+    { 0x9096ea6fu, 0x3848984fu, 0x3ff0d2c8u, 0x5def7621u }, { 0xb4bca50bu, 0x065abe63u, 0x0fed077au, 0x756b53a9u },
+    { 0xe1ebce4du, 0xc7f16dfbu, 0xd3e84959u, 0x12c62894u }, { 0x8d3360f0u, 0x9cf6e4bdu, 0x64712dd7u, 0xabbbd95cu },
+    { 0xb080392cu, 0xc4349decu, 0xbd8d794du, 0x96aacfb3u }, { 0xdca04777u, 0xf541c567u, 0xecf0d7a0u, 0xfc5583a0u },
+    { 0x89e42caau, 0xf9491b60u, 0xf41686c4u, 0x9db57244u }, { 0xac5d37d5u, 0xb79b6239u, 0x311c2875u, 0xc522ced5u },
+    { 0xd77485cbu, 0x25823ac7u, 0x7d633293u, 0x366b828bu }, { 0x86a8d39eu, 0xf77164bcu, 0xae5dff9cu, 0x02033197u },
+    { 0xa8530886u, 0xb54dbdebu, 0xd9f57f83u, 0x0283fdfcu }, { 0xd267caa8u, 0x62a12d66u, 0xd072df63u, 0xc324fd7bu },
+    { 0x8380dea9u, 0x3da4bc60u, 0x4247cb9eu, 0x59f71e6du }, { 0xa4611653u, 0x8d0deb78u, 0x52d9be85u, 0xf074e608u },
+    { 0xcd795be8u, 0x70516656u, 0x67902e27u, 0x6c921f8bu }, { 0x806bd971u, 0x4632dff6u, 0x00ba1cd8u, 0xa3db53b6u },
+    { 0xa086cfcdu, 0x97bf97f3u, 0x80e8a40eu, 0xccd228a4u }, { 0xc8a883c0u, 0xfdaf7df0u, 0x6122cd12u, 0x8006b2cdu },
+    { 0xfad2a4b1u, 0x3d1b5d6cu, 0x796b8057u, 0x20085f81u }, { 0x9cc3a6eeu, 0xc6311a63u, 0xcbe33036u, 0x74053bb0u },
+    { 0xc3f490aau, 0x77bd60fcu, 0xbedbfc44u, 0x11068a9cu }, { 0xf4f1b4d5u, 0x15acb93bu, 0xee92fb55u, 0x15482d44u },
+    { 0x99171105u, 0x2d8bf3c5u, 0x751bdd15u, 0x2d4d1c4au }, { 0xbf5cd546u, 0x78eef0b6u, 0xd262d45au, 0x78a0635du },
+    { 0xef340a98u, 0x172aace4u, 0x86fb8971u, 0x16c87c34u }, { 0x9580869fu, 0x0e7aac0eu, 0xd45d35e6u, 0xae3d4da0u },
+    { 0xbae0a846u, 0xd2195712u, 0x89748360u, 0x59cca109u }, { 0xe998d258u, 0x869facd7u, 0x2bd1a438u, 0x703fc94bu },
+    { 0x91ff8377u, 0x5423cc06u, 0x7b6306a3u, 0x4627ddcfu }, { 0xb67f6455u, 0x292cbf08u, 0x1a3bc84cu, 0x17b1d542u },
+    { 0xe41f3d6au, 0x7377eecau, 0x20caba5fu, 0x1d9e4a93u }, { 0x8e938662u, 0x882af53eu, 0x547eb47bu, 0x7282ee9cu },
+    { 0xb23867fbu, 0x2a35b28du, 0xe99e619au, 0x4f23aa43u }, { 0xdec681f9u, 0xf4c31f31u, 0x6405fa00u, 0xe2ec94d4u },
+    { 0x8b3c113cu, 0x38f9f37eu, 0xde83bc40u, 0x8dd3dd04u }, { 0xae0b158bu, 0x4738705eu, 0x9624ab50u, 0xb148d445u },
+    { 0xd98ddaeeu, 0x19068c76u, 0x3badd624u, 0xdd9b0957u }, { 0x87f8a8d4u, 0xcfa417c9u, 0xe54ca5d7u, 0x0a80e5d6u },
+    { 0xa9f6d30au, 0x038d1dbcu, 0x5e9fcf4cu, 0xcd211f4cu }, { 0xd47487ccu, 0x8470652bu, 0x7647c320u, 0x0069671fu },
+    { 0x84c8d4dfu, 0xd2c63f3bu, 0x29ecd9f4u, 0x0041e073u }, { 0xa5fb0a17u, 0xc777cf09u, 0xf4681071u, 0x00525890u },
+    { 0xcf79cc9du, 0xb955c2ccu, 0x7182148du, 0x4066eeb4u }, { 0x81ac1fe2u, 0x93d599bfu, 0xc6f14cd8u, 0x48405530u },
+    { 0xa21727dbu, 0x38cb002fu, 0xb8ada00eu, 0x5a506a7cu }, { 0xca9cf1d2u, 0x06fdc03bu, 0xa6d90811u, 0xf0e4851cu },
+    { 0xfd442e46u, 0x88bd304au, 0x908f4a16u, 0x6d1da663u }, { 0x9e4a9cecu, 0x15763e2eu, 0x9a598e4eu, 0x043287feu },
+    { 0xc5dd4427u, 0x1ad3cdbau, 0x40eff1e1u, 0x853f29fdu }, { 0xf7549530u, 0xe188c128u, 0xd12bee59u, 0xe68ef47cu },
+    { 0x9a94dd3eu, 0x8cf578b9u, 0x82bb74f8u, 0x301958ceu }, { 0xc13a148eu, 0x3032d6e7u, 0xe36a5236u, 0x3c1faf01u },
+    { 0xf18899b1u, 0xbc3f8ca1u, 0xdc44e6c3u, 0xcb279ac1u }, { 0x96f5600fu, 0x15a7b7e5u, 0x29ab103au, 0x5ef8c0b9u },
+    { 0xbcb2b812u, 0xdb11a5deu, 0x7415d448u, 0xf6b6f0e7u }, { 0xebdf6617u, 0x91d60f56u, 0x111b495bu, 0x3464ad21u },
+    { 0x936b9fceu, 0xbb25c995u, 0xcab10dd9u, 0x00beec34u }, { 0xb84687c2u, 0x69ef3bfbu, 0x3d5d514fu, 0x40eea742u },
+    { 0xe65829b3u, 0x046b0afau, 0x0cb4a5a3u, 0x112a5112u }, { 0x8ff71a0fu, 0xe2c2e6dcu, 0x47f0e785u, 0xeaba72abu },
+    { 0xb3f4e093u, 0xdb73a093u, 0x59ed2167u, 0x65690f56u }, { 0xe0f218b8u, 0xd25088b8u, 0x306869c1u, 0x3ec3532cu },
+    { 0x8c974f73u, 0x83725573u, 0x1e414218u, 0xc73a13fbu }, { 0xafbd2350u, 0x644eeacfu, 0xe5d1929eu, 0xf90898fau },
+    { 0xdbac6c24u, 0x7d62a583u, 0xdf45f746u, 0xb74abf39u }, { 0x894bc396u, 0xce5da772u, 0x6b8bba8cu, 0x328eb783u },
+    { 0xab9eb47cu, 0x81f5114fu, 0x066ea92fu, 0x3f326564u }, { 0xd686619bu, 0xa27255a2u, 0xc80a537bu, 0x0efefebdu },
+    { 0x8613fd01u, 0x45877585u, 0xbd06742cu, 0xe95f5f36u }, { 0xa798fc41u, 0x96e952e7u, 0x2c481138u, 0x23b73704u },
+    { 0xd17f3b51u, 0xfca3a7a0u, 0xf75a1586u, 0x2ca504c5u }, { 0x82ef8513u, 0x3de648c4u, 0x9a984d73u, 0xdbe722fbu },
+    { 0xa3ab6658u, 0x0d5fdaf5u, 0xc13e60d0u, 0xd2e0ebbau }, { 0xcc963feeu, 0x10b7d1b3u, 0x318df905u, 0x079926a8u },
+    { 0xffbbcfe9u, 0x94e5c61fu, 0xfdf17746u, 0x497f7052u }, { 0x9fd561f1u, 0xfd0f9bd3u, 0xfeb6ea8bu, 0xedefa633u },
+    { 0xc7caba6eu, 0x7c5382c8u, 0xfe64a52eu, 0xe96b8fc0u }, { 0xf9bd690au, 0x1b68637bu, 0x3dfdce7au, 0xa3c673b0u },
+    { 0x9c1661a6u, 0x51213e2du, 0x06bea10cu, 0xa65c084eu }, { 0xc31bfa0fu, 0xe5698db8u, 0x486e494fu, 0xcff30a62u },
+    { 0xf3e2f893u, 0xdec3f126u, 0x5a89dba3u, 0xc3efccfau }, { 0x986ddb5cu, 0x6b3a76b7u, 0xf8962946u, 0x5a75e01cu },
+    { 0xbe895233u, 0x86091465u, 0xf6bbb397u, 0xf1135823u }, { 0xee2ba6c0u, 0x678b597fu, 0x746aa07du, 0xed582e2cu },
+    { 0x94db4838u, 0x40b717efu, 0xa8c2a44eu, 0xb4571cdcu }, { 0xba121a46u, 0x50e4ddebu, 0x92f34d62u, 0x616ce413u },
+    { 0xe896a0d7u, 0xe51e1566u, 0x77b020bau, 0xf9c81d17u }, { 0x915e2486u, 0xef32cd60u, 0x0ace1474u, 0xdc1d122eu },
+    { 0xb5b5ada8u, 0xaaff80b8u, 0x0d819992u, 0x132456bau }, { 0xe3231912u, 0xd5bf60e6u, 0x10e1fff6u, 0x97ed6c69u },
+    { 0x8df5efabu, 0xc5979c8fu, 0xca8d3ffau, 0x1ef463c1u }, { 0xb1736b96u, 0xb6fd83b3u, 0xbd308ff8u, 0xa6b17cb2u },
+    { 0xddd0467cu, 0x64bce4a0u, 0xac7cb3f6u, 0xd05ddbdeu }, { 0x8aa22c0du, 0xbef60ee4u, 0x6bcdf07au, 0x423aa96bu },
+    { 0xad4ab711u, 0x2eb3929du, 0x86c16c98u, 0xd2c953c6u }, { 0xd89d64d5u, 0x7a607744u, 0xe871c7bfu, 0x077ba8b7u },
+    { 0x87625f05u, 0x6c7c4a8bu, 0x11471cd7u, 0x64ad4972u }, { 0xa93af6c6u, 0xc79b5d2du, 0xd598e40du, 0x3dd89bcfu },
+    { 0xd389b478u, 0x79823479u, 0x4aff1d10u, 0x8d4ec2c3u }, { 0x843610cbu, 0x4bf160cbu, 0xcedf722au, 0x585139bau },
+    { 0xa54394feu, 0x1eedb8feu, 0xc2974eb4u, 0xee658828u }, { 0xce947a3du, 0xa6a9273eu, 0x733d2262u, 0x29feea32u },
+    { 0x811ccc66u, 0x8829b887u, 0x0806357du, 0x5a3f525fu }, { 0xa163ff80u, 0x2a3426a8u, 0xca07c2dcu, 0xb0cf26f7u },
+    { 0xc9bcff60u, 0x34c13052u, 0xfc89b393u, 0xdd02f0b5u }, { 0xfc2c3f38u, 0x41f17c67u, 0xbbac2078u, 0xd443ace2u },
+    { 0x9d9ba783u, 0x2936edc0u, 0xd54b944bu, 0x84aa4c0du }, { 0xc5029163u, 0xf384a931u, 0x0a9e795eu, 0x65d4df11u },
+    { 0xf64335bcu, 0xf065d37du, 0x4d4617b5u, 0xff4a16d5u }, { 0x99ea0196u, 0x163fa42eu, 0x504bced1u, 0xbf8e4e45u },
+    { 0xc06481fbu, 0x9bcf8d39u, 0xe45ec286u, 0x2f71e1d6u }, { 0xf07da27au, 0x82c37088u, 0x5d767327u, 0xbb4e5a4cu },
+    { 0x964e858cu, 0x91ba2655u, 0x3a6a07f8u, 0xd510f86fu }, { 0xbbe226efu, 0xb628afeau, 0x890489f7u, 0x0a55368bu },
+    { 0xeadab0abu, 0xa3b2dbe5u, 0x2b45ac74u, 0xccea842eu }, { 0x92c8ae6bu, 0x464fc96fu, 0x3b0b8bc9u, 0x0012929du },
+    { 0xb77ada06u, 0x17e3bbcbu, 0x09ce6ebbu, 0x40173744u }, { 0xe5599087u, 0x9ddcaabdu, 0xcc420a6au, 0x101d0515u },
+    { 0x8f57fa54u, 0xc2a9eab6u, 0x9fa94682u, 0x4a12232du }, { 0xb32df8e9u, 0xf3546564u, 0x47939822u, 0xdc96abf9u },
+    { 0xdff97724u, 0x70297ebdu, 0x59787e2bu, 0x93bc56f7u }, { 0x8bfbea76u, 0xc619ef36u, 0x57eb4edbu, 0x3c55b65au },
+    { 0xaefae514u, 0x77a06b03u, 0xede62292u, 0x0b6b23f1u }, { 0xdab99e59u, 0x958885c4u, 0xe95fab36u, 0x8e45ecedu },
+    { 0x88b402f7u, 0xfd75539bu, 0x11dbcb02u, 0x18ebb414u }, { 0xaae103b5u, 0xfcd2a881u, 0xd652bdc2u, 0x9f26a119u },
+    { 0xd59944a3u, 0x7c0752a2u, 0x4be76d33u, 0x46f0495fu }, { 0x857fcae6u, 0x2d8493a5u, 0x6f70a440u, 0x0c562ddbu },
+    { 0xa6dfbd9fu, 0xb8e5b88eu, 0xcb4ccd50u, 0x0f6bb952u }, { 0xd097ad07u, 0xa71f26b2u, 0x7e2000a4u, 0x1346a7a7u },
+    { 0x825ecc24u, 0xc873782fu, 0x8ed40066u, 0x8c0c28c8u }, { 0xa2f67f2du, 0xfa90563bu, 0x72890080u, 0x2f0f32fau },
+    { 0xcbb41ef9u, 0x79346bcau, 0x4f2b40a0u, 0x3ad2ffb9u }, { 0xfea126b7u, 0xd78186bcu, 0xe2f610c8u, 0x4987bfa8u },
+    { 0x9f24b832u, 0xe6b0f436u, 0x0dd9ca7du, 0x2df4d7c9u }, { 0xc6ede63fu, 0xa05d3143u, 0x91503d1cu, 0x79720dbbu },
+    { 0xf8a95fcfu, 0x88747d94u, 0x75a44c63u, 0x97ce912au }, { 0x9b69dbe1u, 0xb548ce7cu, 0xc986afbeu, 0x3ee11abau },
+    { 0xc24452dau, 0x229b021bu, 0xfbe85badu, 0xce996168u }, { 0xf2d56790u, 0xab41c2a2u, 0xfae27299u, 0x423fb9c3u },
+    { 0x97c560bau, 0x6b0919a5u, 0xdccd879fu, 0xc967d41au }, { 0xbdb6b8e9u, 0x05cb600fu, 0x5400e987u, 0xbbc1c920u },
+    { 0xed246723u, 0x473e3813u, 0x290123e9u, 0xaab23b68u }, { 0x9436c076u, 0x0c86e30bu, 0xf9a0b672u, 0x0aaf6521u },
+    { 0xb9447093u, 0x8fa89bceu, 0xf808e40eu, 0x8d5b3e69u }, { 0xe7958cb8u, 0x7392c2c2u, 0xb60b1d12u, 0x30b20e04u },
+    { 0x90bd77f3u, 0x483bb9b9u, 0xb1c6f22bu, 0x5e6f48c2u }, { 0xb4ecd5f0u, 0x1a4aa828u, 0x1e38aeb6u, 0x360b1af3u },
+    { 0xe2280b6cu, 0x20dd5232u, 0x25c6da63u, 0xc38de1b0u }, { 0x8d590723u, 0x948a535fu, 0x579c487eu, 0x5a38ad0eu },
+    { 0xb0af48ecu, 0x79ace837u, 0x2d835a9du, 0xf0c6d851u }, { 0xdcdb1b27u, 0x98182244u, 0xf8e43145u, 0x6cf88e65u },
+    { 0x8a08f0f8u, 0xbf0f156bu, 0x1b8e9ecbu, 0x641b58ffu }, { 0xac8b2d36u, 0xeed2dac5u, 0xe272467eu, 0x3d222f3fu },
+    { 0xd7adf884u, 0xaa879177u, 0x5b0ed81du, 0xcc6abb0fu }, { 0x86ccbb52u, 0xea94baeau, 0x98e94712u, 0x9fc2b4e9u },
+    { 0xa87fea27u, 0xa539e9a5u, 0x3f2398d7u, 0x47b36224u }, { 0xd29fe4b1u, 0x8e88640eu, 0x8eec7f0du, 0x19a03aadu },
+    { 0x83a3eeeeu, 0xf9153e89u, 0x1953cf68u, 0x300424acu }, { 0xa48ceaaau, 0xb75a8e2bu, 0x5fa8c342u, 0x3c052dd7u },
+    { 0xcdb02555u, 0x653131b6u, 0x3792f412u, 0xcb06794du }, { 0x808e1755u, 0x5f3ebf11u, 0xe2bbd88bu, 0xbee40bd0u },
+    { 0xa0b19d2au, 0xb70e6ed6u, 0x5b6aceaeu, 0xae9d0ec4u }, { 0xc8de0475u, 0x64d20a8bu, 0xf245825au, 0x5a445275u },
+    { 0xfb158592u, 0xbe068d2eu, 0xeed6e2f0u, 0xf0d56712u }, { 0x9ced737bu, 0xb6c4183du, 0x55464dd6u, 0x9685606bu },
+    { 0xc428d05au, 0xa4751e4cu, 0xaa97e14cu, 0x3c26b886u }, { 0xf5330471u, 0x4d9265dfu, 0xd53dd99fu, 0x4b3066a8u },
+    { 0x993fe2c6u, 0xd07b7fabu, 0xe546a803u, 0x8efe4029u }, { 0xbf8fdb78u, 0x849a5f96u, 0xde985204u, 0x72bdd033u },
+    { 0xef73d256u, 0xa5c0f77cu, 0x963e6685u, 0x8f6d4440u }, { 0x95a86376u, 0x27989aadu, 0xdde70013u, 0x79a44aa8u },
+    { 0xbb127c53u, 0xb17ec159u, 0x5560c018u, 0x580d5d52u }, { 0xe9d71b68u, 0x9dde71afu, 0xaab8f01eu, 0x6e10b4a6u },
+    { 0x92267121u, 0x62ab070du, 0xcab39613u, 0x04ca70e8u }, { 0xb6b00d69u, 0xbb55c8d1u, 0x3d607b97u, 0xc5fd0d22u },
+    { 0xe45c10c4u, 0x2a2b3b05u, 0x8cb89a7du, 0xb77c506au }, { 0x8eb98a7au, 0x9a5b04e3u, 0x77f3608eu, 0x92adb242u },
+    { 0xb267ed19u, 0x40f1c61cu, 0x55f038b2u, 0x37591ed3u }, { 0xdf01e85fu, 0x912e37a3u, 0x6b6c46deu, 0xc52f6688u },
+    { 0x8b61313bu, 0xbabce2c6u, 0x2323ac4bu, 0x3b3da015u }, { 0xae397d8au, 0xa96c1b77u, 0xabec975eu, 0x0a0d081au },
+    { 0xd9c7dcedu, 0x53c72255u, 0x96e7bd35u, 0x8c904a21u }, { 0x881cea14u, 0x545c7575u, 0x7e50d641u, 0x77da2e54u },
+    { 0xaa242499u, 0x697392d2u, 0xdde50bd1u, 0xd5d0b9e9u }, { 0xd4ad2dbfu, 0xc3d07787u, 0x955e4ec6u, 0x4b44e864u },
+    { 0x84ec3c97u, 0xda624ab4u, 0xbd5af13bu, 0xef0b113eu }, { 0xa6274bbdu, 0xd0fadd61u, 0xecb1ad8au, 0xeacdd58eu },
+    { 0xcfb11eadu, 0x453994bau, 0x67de18edu, 0xa5814af2u }, { 0x81ceb32cu, 0x4b43fcf4u, 0x80eacf94u, 0x8770ced7u },
+    { 0xa2425ff7u, 0x5e14fc31u, 0xa1258379u, 0xa94d028du }, { 0xcad2f7f5u, 0x359a3b3eu, 0x096ee458u, 0x13a04330u },
+    { 0xfd87b5f2u, 0x8300ca0du, 0x8bca9d6eu, 0x188853fcu }, { 0x9e74d1b7u, 0x91e07e48u, 0x775ea264u, 0xcf55347eu },
+    { 0xc6120625u, 0x76589ddau, 0x95364afeu, 0x032a819eu }, { 0xf79687aeu, 0xd3eec551u, 0x3a83ddbdu, 0x83f52205u },
+    { 0x9abe14cdu, 0x44753b52u, 0xc4926a96u, 0x72793543u }, { 0xc16d9a00u, 0x95928a27u, 0x75b7053cu, 0x0f178294u },
+    { 0xf1c90080u, 0xbaf72cb1u, 0x5324c68bu, 0x12dd6339u }, { 0x971da050u, 0x74da7beeu, 0xd3f6fc16u, 0xebca5e04u },
+    { 0xbce50864u, 0x92111aeau, 0x88f4bb1cu, 0xa6bcf585u }, { 0xec1e4a7du, 0xb69561a5u, 0x2b31e9e3u, 0xd06c32e6u },
+    { 0x9392ee8eu, 0x921d5d07u, 0x3aff322eu, 0x62439fd0u }, { 0xb877aa32u, 0x36a4b449u, 0x09befeb9u, 0xfad487c3u },
+    { 0xe69594beu, 0xc44de15bu, 0x4c2ebe68u, 0x7989a9b4u }, { 0x901d7cf7u, 0x3ab0acd9u, 0x0f9d3701u, 0x4bf60a11u },
+    { 0xb424dc35u, 0x095cd80fu, 0x538484c1u, 0x9ef38c95u }, { 0xe12e1342u, 0x4bb40e13u, 0x2865a5f2u, 0x06b06fbau },
+    { 0x8cbccc09u, 0x6f5088cbu, 0xf93f87b7u, 0x442e45d4u }, { 0xafebff0bu, 0xcb24aafeu, 0xf78f69a5u, 0x1539d749u },
+    { 0xdbe6feceu, 0xbdedd5beu, 0xb573440eu, 0x5a884d1cu }, { 0x89705f41u, 0x36b4a597u, 0x31680a88u, 0xf8953031u },
+    { 0xabcc7711u, 0x8461cefcu, 0xfdc20d2bu, 0x36ba7c3eu }, { 0xd6bf94d5u, 0xe57a42bcu, 0x3d329076u, 0x04691b4du },
+    { 0x8637bd05u, 0xaf6c69b5u, 0xa63f9a49u, 0xc2c1b110u }, { 0xa7c5ac47u, 0x1b478423u, 0x0fcf80dcu, 0x33721d54u },
+    { 0xd1b71758u, 0xe219652bu, 0xd3c36113u, 0x404ea4a9u }, { 0x83126e97u, 0x8d4fdf3bu, 0x645a1cacu, 0x083126eau },
+    { 0xa3d70a3du, 0x70a3d70au, 0x3d70a3d7u, 0x0a3d70a4u }, { 0xccccccccu, 0xccccccccu, 0xccccccccu, 0xcccccccdu },
+    { 0x80000000u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0xa0000000u, 0x00000000u, 0x00000000u, 0x00000000u },
+    { 0xc8000000u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0xfa000000u, 0x00000000u, 0x00000000u, 0x00000000u },
+    { 0x9c400000u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0xc3500000u, 0x00000000u, 0x00000000u, 0x00000000u },
+    { 0xf4240000u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0x98968000u, 0x00000000u, 0x00000000u, 0x00000000u },
+    { 0xbebc2000u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0xee6b2800u, 0x00000000u, 0x00000000u, 0x00000000u },
+    { 0x9502f900u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0xba43b740u, 0x00000000u, 0x00000000u, 0x00000000u },
+    { 0xe8d4a510u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0x9184e72au, 0x00000000u, 0x00000000u, 0x00000000u },
+    { 0xb5e620f4u, 0x80000000u, 0x00000000u, 0x00000000u }, { 0xe35fa931u, 0xa0000000u, 0x00000000u, 0x00000000u },
+    { 0x8e1bc9bfu, 0x04000000u, 0x00000000u, 0x00000000u }, { 0xb1a2bc2eu, 0xc5000000u, 0x00000000u, 0x00000000u },
+    { 0xde0b6b3au, 0x76400000u, 0x00000000u, 0x00000000u }, { 0x8ac72304u, 0x89e80000u, 0x00000000u, 0x00000000u },
+    { 0xad78ebc5u, 0xac620000u, 0x00000000u, 0x00000000u }, { 0xd8d726b7u, 0x177a8000u, 0x00000000u, 0x00000000u },
+    { 0x87867832u, 0x6eac9000u, 0x00000000u, 0x00000000u }, { 0xa968163fu, 0x0a57b400u, 0x00000000u, 0x00000000u },
+    { 0xd3c21bceu, 0xcceda100u, 0x00000000u, 0x00000000u }, { 0x84595161u, 0x401484a0u, 0x00000000u, 0x00000000u },
+    { 0xa56fa5b9u, 0x9019a5c8u, 0x00000000u, 0x00000000u }, { 0xcecb8f27u, 0xf4200f3au, 0x00000000u, 0x00000000u },
+    { 0x813f3978u, 0xf8940984u, 0x40000000u, 0x00000000u }, { 0xa18f07d7u, 0x36b90be5u, 0x50000000u, 0x00000000u },
+    { 0xc9f2c9cdu, 0x04674edeu, 0xa4000000u, 0x00000000u }, { 0xfc6f7c40u, 0x45812296u, 0x4d000000u, 0x00000000u },
+    { 0x9dc5ada8u, 0x2b70b59du, 0xf0200000u, 0x00000000u }, { 0xc5371912u, 0x364ce305u, 0x6c280000u, 0x00000000u },
+    { 0xf684df56u, 0xc3e01bc6u, 0xc7320000u, 0x00000000u }, { 0x9a130b96u, 0x3a6c115cu, 0x3c7f4000u, 0x00000000u },
+    { 0xc097ce7bu, 0xc90715b3u, 0x4b9f1000u, 0x00000000u }, { 0xf0bdc21au, 0xbb48db20u, 0x1e86d400u, 0x00000000u },
+    { 0x96769950u, 0xb50d88f4u, 0x13144480u, 0x00000000u }, { 0xbc143fa4u, 0xe250eb31u, 0x17d955a0u, 0x00000000u },
+    { 0xeb194f8eu, 0x1ae525fdu, 0x5dcfab08u, 0x00000000u }, { 0x92efd1b8u, 0xd0cf37beu, 0x5aa1cae5u, 0x00000000u },
+    { 0xb7abc627u, 0x050305adu, 0xf14a3d9eu, 0x40000000u }, { 0xe596b7b0u, 0xc643c719u, 0x6d9ccd05u, 0xd0000000u },
+    { 0x8f7e32ceu, 0x7bea5c6fu, 0xe4820023u, 0xa2000000u }, { 0xb35dbf82u, 0x1ae4f38bu, 0xdda2802cu, 0x8a800000u },
+    { 0xe0352f62u, 0xa19e306eu, 0xd50b2037u, 0xad200000u }, { 0x8c213d9du, 0xa502de45u, 0x4526f422u, 0xcc340000u },
+    { 0xaf298d05u, 0x0e4395d6u, 0x9670b12bu, 0x7f410000u }, { 0xdaf3f046u, 0x51d47b4cu, 0x3c0cdd76u, 0x5f114000u },
+    { 0x88d8762bu, 0xf324cd0fu, 0xa5880a69u, 0xfb6ac800u }, { 0xab0e93b6u, 0xefee0053u, 0x8eea0d04u, 0x7a457a00u },
+    { 0xd5d238a4u, 0xabe98068u, 0x72a49045u, 0x98d6d880u }, { 0x85a36366u, 0xeb71f041u, 0x47a6da2bu, 0x7f864750u },
+    { 0xa70c3c40u, 0xa64e6c51u, 0x999090b6u, 0x5f67d924u }, { 0xd0cf4b50u, 0xcfe20765u, 0xfff4b4e3u, 0xf741cf6du },
+    { 0x82818f12u, 0x81ed449fu, 0xbff8f10eu, 0x7a8921a4u }, { 0xa321f2d7u, 0x226895c7u, 0xaff72d52u, 0x192b6a0du },
+    { 0xcbea6f8cu, 0xeb02bb39u, 0x9bf4f8a6u, 0x9f764490u }, { 0xfee50b70u, 0x25c36a08u, 0x02f236d0u, 0x4753d5b4u },
+    { 0x9f4f2726u, 0x179a2245u, 0x01d76242u, 0x2c946590u }, { 0xc722f0efu, 0x9d80aad6u, 0x424d3ad2u, 0xb7b97ef5u },
+    { 0xf8ebad2bu, 0x84e0d58bu, 0xd2e08987u, 0x65a7deb2u }, { 0x9b934c3bu, 0x330c8577u, 0x63cc55f4u, 0x9f88eb2fu },
+    { 0xc2781f49u, 0xffcfa6d5u, 0x3cbf6b71u, 0xc76b25fbu }, { 0xf316271cu, 0x7fc3908au, 0x8bef464eu, 0x3945ef7au },
+    { 0x97edd871u, 0xcfda3a56u, 0x97758bf0u, 0xe3cbb5acu }, { 0xbde94e8eu, 0x43d0c8ecu, 0x3d52eeedu, 0x1cbea317u },
+    { 0xed63a231u, 0xd4c4fb27u, 0x4ca7aaa8u, 0x63ee4bddu }, { 0x945e455fu, 0x24fb1cf8u, 0x8fe8caa9u, 0x3e74ef6au },
+    { 0xb975d6b6u, 0xee39e436u, 0xb3e2fd53u, 0x8e122b44u }, { 0xe7d34c64u, 0xa9c85d44u, 0x60dbbca8u, 0x7196b616u },
+    { 0x90e40fbeu, 0xea1d3a4au, 0xbc8955e9u, 0x46fe31cdu }, { 0xb51d13aeu, 0xa4a488ddu, 0x6babab63u, 0x98bdbe41u },
+    { 0xe264589au, 0x4dcdab14u, 0xc696963cu, 0x7eed2dd1u }, { 0x8d7eb760u, 0x70a08aecu, 0xfc1e1de5u, 0xcf543ca2u },
+    { 0xb0de6538u, 0x8cc8ada8u, 0x3b25a55fu, 0x43294bcbu }, { 0xdd15fe86u, 0xaffad912u, 0x49ef0eb7u, 0x13f39ebeu },
+    { 0x8a2dbf14u, 0x2dfcc7abu, 0x6e356932u, 0x6c784337u }, { 0xacb92ed9u, 0x397bf996u, 0x49c2c37fu, 0x07965404u },
+    { 0xd7e77a8fu, 0x87daf7fbu, 0xdc33745eu, 0xc97be906u }, { 0x86f0ac99u, 0xb4e8dafdu, 0x69a028bbu, 0x3ded71a3u },
+    { 0xa8acd7c0u, 0x222311bcu, 0xc40832eau, 0x0d68ce0cu }, { 0xd2d80db0u, 0x2aabd62bu, 0xf50a3fa4u, 0x90c30190u },
+    { 0x83c7088eu, 0x1aab65dbu, 0x792667c6u, 0xda79e0fau }, { 0xa4b8cab1u, 0xa1563f52u, 0x577001b8u, 0x91185938u },
+    { 0xcde6fd5eu, 0x09abcf26u, 0xed4c0226u, 0xb55e6f86u }, { 0x80b05e5au, 0xc60b6178u, 0x544f8158u, 0x315b05b4u },
+    { 0xa0dc75f1u, 0x778e39d6u, 0x696361aeu, 0x3db1c721u }, { 0xc913936du, 0xd571c84cu, 0x03bc3a19u, 0xcd1e38e9u },
+    { 0xfb587849u, 0x4ace3a5fu, 0x04ab48a0u, 0x4065c723u }, { 0x9d174b2du, 0xcec0e47bu, 0x62eb0d64u, 0x283f9c76u },
+    { 0xc45d1df9u, 0x42711d9au, 0x3ba5d0bdu, 0x324f8394u }, { 0xf5746577u, 0x930d6500u, 0xca8f44ecu, 0x7ee36479u },
+    { 0x9968bf6au, 0xbbe85f20u, 0x7e998b13u, 0xcf4e1ecbu }, { 0xbfc2ef45u, 0x6ae276e8u, 0x9e3fedd8u, 0xc321a67eu },
+    { 0xefb3ab16u, 0xc59b14a2u, 0xc5cfe94eu, 0xf3ea101eu }, { 0x95d04aeeu, 0x3b80ece5u, 0xbba1f1d1u, 0x58724a12u },
+    { 0xbb445da9u, 0xca61281fu, 0x2a8a6e45u, 0xae8edc97u }, { 0xea157514u, 0x3cf97226u, 0xf52d09d7u, 0x1a3293bdu },
+    { 0x924d692cu, 0xa61be758u, 0x593c2626u, 0x705f9c56u }, { 0xb6e0c377u, 0xcfa2e12eu, 0x6f8b2fb0u, 0x0c77836cu },
+    { 0xe498f455u, 0xc38b997au, 0x0b6dfb9cu, 0x0f956447u }, { 0x8edf98b5u, 0x9a373fecu, 0x4724bd41u, 0x89bd5eacu },
+    { 0xb2977ee3u, 0x00c50fe7u, 0x58edec91u, 0xec2cb657u }, { 0xdf3d5e9bu, 0xc0f653e1u, 0x2f2967b6u, 0x6737e3edu },
+    { 0x8b865b21u, 0x5899f46cu, 0xbd79e0d2u, 0x0082ee74u }, { 0xae67f1e9u, 0xaec07187u, 0xecd85906u, 0x80a3aa11u },
+    { 0xda01ee64u, 0x1a708de9u, 0xe80e6f48u, 0x20cc9495u }, { 0x884134feu, 0x908658b2u, 0x3109058du, 0x147fdcddu },
+    { 0xaa51823eu, 0x34a7eedeu, 0xbd4b46f0u, 0x599fd415u }, { 0xd4e5e2cdu, 0xc1d1ea96u, 0x6c9e18acu, 0x7007c91au },
+    { 0x850fadc0u, 0x9923329eu, 0x03e2cf6bu, 0xc604ddb0u }, { 0xa6539930u, 0xbf6bff45u, 0x84db8346u, 0xb786151cu },
+    { 0xcfe87f7cu, 0xef46ff16u, 0xe6126418u, 0x65679a63u }, { 0x81f14faeu, 0x158c5f6eu, 0x4fcb7e8fu, 0x3f60c07eu },
+    { 0xa26da399u, 0x9aef7749u, 0xe3be5e33u, 0x0f38f09du }, { 0xcb090c80u, 0x01ab551cu, 0x5cadf5bfu, 0xd3072cc5u },
+    { 0xfdcb4fa0u, 0x02162a63u, 0x73d9732fu, 0xc7c8f7f6u }, { 0x9e9f11c4u, 0x014dda7eu, 0x2867e7fdu, 0xdcdd9afau },
+    { 0xc646d635u, 0x01a1511du, 0xb281e1fdu, 0x541501b8u }, { 0xf7d88bc2u, 0x4209a565u, 0x1f225a7cu, 0xa91a4226u },
+    { 0x9ae75759u, 0x6946075fu, 0x3375788du, 0xe9b06958u }, { 0xc1a12d2fu, 0xc3978937u, 0x0052d6b1u, 0x641c83aeu },
+    { 0xf209787bu, 0xb47d6b84u, 0xc0678c5du, 0xbd23a49au }, { 0x9745eb4du, 0x50ce6332u, 0xf840b7bau, 0x963646e0u },
+    { 0xbd176620u, 0xa501fbffu, 0xb650e5a9u, 0x3bc3d898u }, { 0xec5d3fa8u, 0xce427affu, 0xa3e51f13u, 0x8ab4cebeu },
+    { 0x93ba47c9u, 0x80e98cdfu, 0xc66f336cu, 0x36b10137u }, { 0xb8a8d9bbu, 0xe123f017u, 0xb80b0047u, 0x445d4184u },
+    { 0xe6d3102au, 0xd96cec1du, 0xa60dc059u, 0x157491e5u }, { 0x9043ea1au, 0xc7e41392u, 0x87c89837u, 0xad68db2fu },
+    { 0xb454e4a1u, 0x79dd1877u, 0x29babe45u, 0x98c311fbu }, { 0xe16a1dc9u, 0xd8545e94u, 0xf4296dd6u, 0xfef3d67au },
+    { 0x8ce2529eu, 0x2734bb1du, 0x1899e4a6u, 0x5f58660cu }, { 0xb01ae745u, 0xb101e9e4u, 0x5ec05dcfu, 0xf72e7f8fu },
+    { 0xdc21a117u, 0x1d42645du, 0x76707543u, 0xf4fa1f73u }, { 0x899504aeu, 0x72497ebau, 0x6a06494au, 0x791c53a8u },
+    { 0xabfa45dau, 0x0edbde69u, 0x0487db9du, 0x17636892u }, { 0xd6f8d750u, 0x9292d603u, 0x45a9d284u, 0x5d3c42b6u },
+    { 0x865b8692u, 0x5b9bc5c2u, 0x0b8a2392u, 0xba45a9b2u }, { 0xa7f26836u, 0xf282b732u, 0x8e6cac77u, 0x68d7141eu },
+    { 0xd1ef0244u, 0xaf2364ffu, 0x3207d795u, 0x430cd926u }, { 0x8335616au, 0xed761f1fu, 0x7f44e6bdu, 0x49e807b8u },
+    { 0xa402b9c5u, 0xa8d3a6e7u, 0x5f16206cu, 0x9c6209a6u }, { 0xcd036837u, 0x130890a1u, 0x36dba887u, 0xc37a8c0fu },
+    { 0x80222122u, 0x6be55a64u, 0xc2494954u, 0xda2c9789u }, { 0xa02aa96bu, 0x06deb0fdu, 0xf2db9baau, 0x10b7bd6cu },
+    { 0xc83553c5u, 0xc8965d3du, 0x6f928294u, 0x94e5acc7u }, { 0xfa42a8b7u, 0x3abbf48cu, 0xcb772339u, 0xba1f17f9u },
+    { 0x9c69a972u, 0x84b578d7u, 0xff2a7604u, 0x14536efbu }, { 0xc38413cfu, 0x25e2d70du, 0xfef51385u, 0x19684abau },
+    { 0xf46518c2u, 0xef5b8cd1u, 0x7eb25866u, 0x5fc25d69u }, { 0x98bf2f79u, 0xd5993802u, 0xef2f773fu, 0xfbd97a61u },
+    { 0xbeeefb58u, 0x4aff8603u, 0xaafb550fu, 0xfacfd8fau }, { 0xeeaaba2eu, 0x5dbf6784u, 0x95ba2a53u, 0xf983cf38u },
+    { 0x952ab45cu, 0xfa97a0b2u, 0xdd945a74u, 0x7bf26183u }, { 0xba756174u, 0x393d88dfu, 0x94f97111u, 0x9aeef9e4u },
+    { 0xe912b9d1u, 0x478ceb17u, 0x7a37cd56u, 0x01aab85du }, { 0x91abb422u, 0xccb812eeu, 0xac62e055u, 0xc10ab33au },
+    { 0xb616a12bu, 0x7fe617aau, 0x577b986bu, 0x314d6009u }, { 0xe39c4976u, 0x5fdf9d94u, 0xed5a7e85u, 0xfda0b80bu },
+    { 0x8e41ade9u, 0xfbebc27du, 0x14588f13u, 0xbe847307u }, { 0xb1d21964u, 0x7ae6b31cu, 0x596eb2d8u, 0xae258fc8u },
+    { 0xde469fbdu, 0x99a05fe3u, 0x6fca5f8eu, 0xd9aef3bbu }, { 0x8aec23d6u, 0x80043beeu, 0x25de7bb9u, 0x480d5854u },
+    { 0xada72cccu, 0x20054ae9u, 0xaf561aa7u, 0x9a10ae6au }, { 0xd910f7ffu, 0x28069da4u, 0x1b2ba151u, 0x8094da04u },
+    { 0x87aa9affu, 0x79042286u, 0x90fb44d2u, 0xf05d0842u }, { 0xa99541bfu, 0x57452b28u, 0x353a1607u, 0xac744a53u },
+    { 0xd3fa922fu, 0x2d1675f2u, 0x42889b89u, 0x97915ce8u }, { 0x847c9b5du, 0x7c2e09b7u, 0x69956135u, 0xfebada11u },
+    { 0xa59bc234u, 0xdb398c25u, 0x43fab983u, 0x7e699095u }, { 0xcf02b2c2u, 0x1207ef2eu, 0x94f967e4u, 0x5e03f4bbu },
+    { 0x8161afb9u, 0x4b44f57du, 0x1d1be0eeu, 0xbac278f5u }, { 0xa1ba1ba7u, 0x9e1632dcu, 0x6462d92au, 0x69731732u },
+    { 0xca28a291u, 0x859bbf93u, 0x7d7b8f75u, 0x03cfdcfeu }, { 0xfcb2cb35u, 0xe702af78u, 0x5cda7352u, 0x44c3d43eu },
+    { 0x9defbf01u, 0xb061adabu, 0x3a088813u, 0x6afa64a7u }, { 0xc56baec2u, 0x1c7a1916u, 0x088aaa18u, 0x45b8fdd0u },
+    { 0xf6c69a72u, 0xa3989f5bu, 0x8aad549eu, 0x57273d45u }, { 0x9a3c2087u, 0xa63f6399u, 0x36ac54e2u, 0xf678864bu },
+    { 0xc0cb28a9u, 0x8fcf3c7fu, 0x84576a1bu, 0xb416a7ddu }, { 0xf0fdf2d3u, 0xf3c30b9fu, 0x656d44a2u, 0xa11c51d5u },
+    { 0x969eb7c4u, 0x7859e743u, 0x9f644ae5u, 0xa4b1b325u }, { 0xbc4665b5u, 0x96706114u, 0x873d5d9fu, 0x0dde1feeu },
+    { 0xeb57ff22u, 0xfc0c7959u, 0xa90cb506u, 0xd155a7eau }, { 0x9316ff75u, 0xdd87cbd8u, 0x09a7f124u, 0x42d588f2u },
+    { 0xb7dcbf53u, 0x54e9beceu, 0x0c11ed6du, 0x538aeb2fu }, { 0xe5d3ef28u, 0x2a242e81u, 0x8f1668c8u, 0xa86da5fau },
+    { 0x8fa47579u, 0x1a569d10u, 0xf96e017du, 0x694487bcu }, { 0xb38d92d7u, 0x60ec4455u, 0x37c981dcu, 0xc395a9acu },
+    { 0xe070f78du, 0x3927556au, 0x85bbe253u, 0xf47b1417u }, { 0x8c469ab8u, 0x43b89562u, 0x93956d74u, 0x78ccec8eu },
+    { 0xaf584166u, 0x54a6babbu, 0x387ac8d1u, 0x970027b2u }, { 0xdb2e51bfu, 0xe9d0696au, 0x06997b05u, 0xfcc0319eu },
+    { 0x88fcf317u, 0xf22241e2u, 0x441fece3u, 0xbdf81f03u }, { 0xab3c2fddu, 0xeeaad25au, 0xd527e81cu, 0xad7626c3u },
+    { 0xd60b3bd5u, 0x6a5586f1u, 0x8a71e223u, 0xd8d3b074u }, { 0x85c70565u, 0x62757456u, 0xf6872d56u, 0x67844e49u },
+    { 0xa738c6beu, 0xbb12d16cu, 0xb428f8acu, 0x016561dbu }, { 0xd106f86eu, 0x69d785c7u, 0xe13336d7u, 0x01beba52u },
+    { 0x82a45b45u, 0x0226b39cu, 0xecc00246u, 0x61173473u }, { 0xa34d7216u, 0x42b06084u, 0x27f002d7u, 0xf95d0190u },
+    { 0xcc20ce9bu, 0xd35c78a5u, 0x31ec038du, 0xf7b441f4u }, { 0xff290242u, 0xc83396ceu, 0x7e670471u, 0x75a15271u },
+    { 0x9f79a169u, 0xbd203e41u, 0x0f0062c6u, 0xe984d386u }, { 0xc75809c4u, 0x2c684dd1u, 0x52c07b78u, 0xa3e60868u },
+    { 0xf92e0c35u, 0x37826145u, 0xa7709a56u, 0xccdf8a82u }, { 0x9bbcc7a1u, 0x42b17ccbu, 0x88a66076u, 0x400bb691u },
+    { 0xc2abf989u, 0x935ddbfeu, 0x6acff893u, 0xd00ea435u }, { 0xf356f7ebu, 0xf83552feu, 0x0583f6b8u, 0xc4124d43u },
+    { 0x98165af3u, 0x7b2153deu, 0xc3727a33u, 0x7a8b704au }, { 0xbe1bf1b0u, 0x59e9a8d6u, 0x744f18c0u, 0x592e4c5cu },
+    { 0xeda2ee1cu, 0x7064130cu, 0x1162def0u, 0x6f79df73u }, { 0x9485d4d1u, 0xc63e8be7u, 0x8addcb56u, 0x45ac2ba8u },
+    { 0xb9a74a06u, 0x37ce2ee1u, 0x6d953e2bu, 0xd7173692u }, { 0xe8111c87u, 0xc5c1ba99u, 0xc8fa8db6u, 0xccdd0437u },
+    { 0x910ab1d4u, 0xdb9914a0u, 0x1d9c9892u, 0x400a22a2u }, { 0xb54d5e4au, 0x127f59c8u, 0x2503beb6u, 0xd00cab4bu },
+    { 0xe2a0b5dcu, 0x971f303au, 0x2e44ae64u, 0x840fd61du }, { 0x8da471a9u, 0xde737e24u, 0x5ceaecfeu, 0xd289e5d2u },
+    { 0xb10d8e14u, 0x56105dadu, 0x7425a83eu, 0x872c5f47u }, { 0xdd50f199u, 0x6b947518u, 0xd12f124eu, 0x28f77719u },
+    { 0x8a5296ffu, 0xe33cc92fu, 0x82bd6b70u, 0xd99aaa6fu }, { 0xace73cbfu, 0xdc0bfb7bu, 0x636cc64du, 0x1001550bu },
+    { 0xd8210befu, 0xd30efa5au, 0x3c47f7e0u, 0x5401aa4eu }, { 0x8714a775u, 0xe3e95c78u, 0x65acfaecu, 0x34810a71u },
+    { 0xa8d9d153u, 0x5ce3b396u, 0x7f1839a7u, 0x41a14d0du }, { 0xd31045a8u, 0x341ca07cu, 0x1ede4811u, 0x1209a050u },
+    { 0x83ea2b89u, 0x2091e44du, 0x934aed0au, 0xab460432u }, { 0xa4e4b66bu, 0x68b65d60u, 0xf81da84du, 0x5617853fu },
+    { 0xce1de406u, 0x42e3f4b9u, 0x36251260u, 0xab9d668eu }, { 0x80d2ae83u, 0xe9ce78f3u, 0xc1d72b7cu, 0x6b426019u },
+    { 0xa1075a24u, 0xe4421730u, 0xb24cf65bu, 0x8612f81fu }, { 0xc94930aeu, 0x1d529cfcu, 0xdee033f2u, 0x6797b627u },
+    { 0xfb9b7cd9u, 0xa4a7443cu, 0x169840efu, 0x017da3b1u }, { 0x9d412e08u, 0x06e88aa5u, 0x8e1f2895u, 0x60ee864eu },
+    { 0xc491798au, 0x08a2ad4eu, 0xf1a6f2bau, 0xb92a27e2u }, { 0xf5b5d7ecu, 0x8acb58a2u, 0xae10af69u, 0x6774b1dbu },
+    { 0x9991a6f3u, 0xd6bf1765u, 0xacca6da1u, 0xe0a8ef29u }, { 0xbff610b0u, 0xcc6edd3fu, 0x17fd090au, 0x58d32af3u },
+    { 0xeff394dcu, 0xff8a948eu, 0xddfc4b4cu, 0xef07f5b0u }, { 0x95f83d0au, 0x1fb69cd9u, 0x4abdaf10u, 0x1564f98eu },
+    { 0xbb764c4cu, 0xa7a4440fu, 0x9d6d1ad4u, 0x1abe37f1u }, { 0xea53df5fu, 0xd18d5513u, 0x84c86189u, 0x216dc5edu },
+    { 0x92746b9bu, 0xe2f8552cu, 0x32fd3cf5u, 0xb4e49bb4u }, { 0xb7118682u, 0xdbb66a77u, 0x3fbc8c33u, 0x221dc2a1u },
+    { 0xe4d5e823u, 0x92a40515u, 0x0fabaf3fu, 0xeaa5334au }, { 0x8f05b116u, 0x3ba6832du, 0x29cb4d87u, 0xf2a7400eu },
+    { 0xb2c71d5bu, 0xca9023f8u, 0x743e20e9u, 0xef511012u }, { 0xdf78e4b2u, 0xbd342cf6u, 0x914da924u, 0x6b255416u },
+    { 0x8bab8eefu, 0xb6409c1au, 0x1ad089b6u, 0xc2f7548eu }, { 0xae9672abu, 0xa3d0c320u, 0xa184ac24u, 0x73b529b1u },
+    { 0xda3c0f56u, 0x8cc4f3e8u, 0xc9e5d72du, 0x90a2741eu }, { 0x88658996u, 0x17fb1871u, 0x7e2fa67cu, 0x7a658892u },
+    { 0xaa7eebfbu, 0x9df9de8du, 0xddbb901bu, 0x98feeab7u }, { 0xd51ea6fau, 0x85785631u, 0x552a7422u, 0x7f3ea565u },
+    { 0x8533285cu, 0x936b35deu, 0xd53a8895u, 0x8f87275fu }, { 0xa67ff273u, 0xb8460356u, 0x8a892abau, 0xf368f137u },
+    { 0xd01fef10u, 0xa657842cu, 0x2d2b7569u, 0xb0432d85u }, { 0x8213f56au, 0x67f6b29bu, 0x9c3b2962u, 0x0e29fc73u },
+    { 0xa298f2c5u, 0x01f45f42u, 0x8349f3bau, 0x91b47b8fu }, { 0xcb3f2f76u, 0x42717713u, 0x241c70a9u, 0x36219a73u },
+    { 0xfe0efb53u, 0xd30dd4d7u, 0xed238cd3u, 0x83aa0110u }, { 0x9ec95d14u, 0x63e8a506u, 0xf4363804u, 0x324a40aau },
+    { 0xc67bb459u, 0x7ce2ce48u, 0xb143c605u, 0x3edcd0d5u }, { 0xf81aa16fu, 0xdc1b81dau, 0xdd94b786u, 0x8e94050au },
+    { 0x9b10a4e5u, 0xe9913128u, 0xca7cf2b4u, 0x191c8326u }, { 0xc1d4ce1fu, 0x63f57d72u, 0xfd1c2f61u, 0x1f63a3f0u },
+    { 0xf24a01a7u, 0x3cf2dccfu, 0xbc633b39u, 0x673c8cecu }, { 0x976e4108u, 0x8617ca01u, 0xd5be0503u, 0xe085d813u },
+    { 0xbd49d14au, 0xa79dbc82u, 0x4b2d8644u, 0xd8a74e18u }, { 0xec9c459du, 0x51852ba2u, 0xddf8e7d6u, 0x0ed1219eu },
+    { 0x93e1ab82u, 0x52f33b45u, 0xcabb90e5u, 0xc942b503u }, { 0xb8da1662u, 0xe7b00a17u, 0x3d6a751fu, 0x3b936243u },
+    { 0xe7109bfbu, 0xa19c0c9du, 0x0cc51267u, 0x0a783ad4u }, { 0x906a617du, 0x450187e2u, 0x27fb2b80u, 0x668b24c5u },
+    { 0xb484f9dcu, 0x9641e9dau, 0xb1f9f660u, 0x802dedf6u }, { 0xe1a63853u, 0xbbd26451u, 0x5e7873f8u, 0xa0396973u },
+    { 0x8d07e334u, 0x55637eb2u, 0xdb0b487bu, 0x6423e1e8u }, { 0xb049dc01u, 0x6abc5e5fu, 0x91ce1a9au, 0x3d2cda62u },
+    { 0xdc5c5301u, 0xc56b75f7u, 0x7641a140u, 0xcc7810fbu }, { 0x89b9b3e1u, 0x1b6329bau, 0xa9e904c8u, 0x7fcb0a9du },
+    { 0xac2820d9u, 0x623bf429u, 0x546345fau, 0x9fbdcd44u }, { 0xd732290fu, 0xbacaf133u, 0xa97c1779u, 0x47ad4095u },
+    { 0x867f59a9u, 0xd4bed6c0u, 0x49ed8eabu, 0xcccc485du }, { 0xa81f3014u, 0x49ee8c70u, 0x5c68f256u, 0xbfff5a74u },
+    { 0xd226fc19u, 0x5c6a2f8cu, 0x73832eecu, 0x6fff3111u }, { 0x83585d8fu, 0xd9c25db7u, 0xc831fd53u, 0xc5ff7eabu },
+    { 0xa42e74f3u, 0xd032f525u, 0xba3e7ca8u, 0xb77f5e55u }, { 0xcd3a1230u, 0xc43fb26fu, 0x28ce1bd2u, 0xe55f35ebu },
+    { 0x80444b5eu, 0x7aa7cf85u, 0x7980d163u, 0xcf5b81b3u }, { 0xa0555e36u, 0x1951c366u, 0xd7e105bcu, 0xc332621fu },
+    { 0xc86ab5c3u, 0x9fa63440u, 0x8dd9472bu, 0xf3fefaa7u }, { 0xfa856334u, 0x878fc150u, 0xb14f98f6u, 0xf0feb951u },
+    { 0x9c935e00u, 0xd4b9d8d2u, 0x6ed1bf9au, 0x569f33d3u }, { 0xc3b83581u, 0x09e84f07u, 0x0a862f80u, 0xec4700c8u },
+    { 0xf4a642e1u, 0x4c6262c8u, 0xcd27bb61u, 0x2758c0fau }, { 0x98e7e9ccu, 0xcfbd7dbdu, 0x8038d51cu, 0xb897789cu },
+    { 0xbf21e440u, 0x03acdd2cu, 0xe0470a63u, 0xe6bd56c3u }, { 0xeeea5d50u, 0x04981478u, 0x1858ccfcu, 0xe06cac74u },
+    { 0x95527a52u, 0x02df0ccbu, 0x0f37801eu, 0x0c43ebc8u }, { 0xbaa718e6u, 0x8396cffdu, 0xd3056025u, 0x8f54e6bau },
+    { 0xe950df20u, 0x247c83fdu, 0x47c6b82eu, 0xf32a2069u }, { 0x91d28b74u, 0x16cdd27eu, 0x4cdc331du, 0x57fa5441u },
+    { 0xb6472e51u, 0x1c81471du, 0xe0133fe4u, 0xadf8e952u }, { 0xe3d8f9e5u, 0x63a198e5u, 0x58180fddu, 0xd97723a6u },
+    { 0x8e679c2fu, 0x5e44ff8fu, 0x570f09eau, 0xa7ea7648u }
+};
+
+static const double lept_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int lept_clz64(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    for (; !(x >> 63); x <<= 1)
+        n++;
+    return n;
+#endif
+}
+
+/* Returns the high 64 bits of a * b, and stores the low 64 bits in *lo. */
+static uint64_t lept_umul128(uint64_t a, uint64_t b, uint64_t* lo) {
+    uint64_t a0 = (uint32_t)a, a1 = a >> 32, b0 = (uint32_t)b, b1 = b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+    *lo = (mid << 32) | (uint32_t)p00;
+    return p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+}
+
+/* Bits of the double nearest to w * 10^q (w > 0), or LEPT_DOUBLE_INF on overflow. */
+static uint64_t lept_eisel_lemire(uint64_t w, long q) {
+    const uint32_t* t;
+    uint64_t hi, lo, hi2, lo2, m;
+    long e2, p;
+    int lz, upper, shift;
+    if (q < LEPT_POW5_MIN)
+        return 0;
+    if (q > LEPT_POW5_MAX)
+        return LEPT_DOUBLE_INF;
+    lz = lept_clz64(w);
+    w <<= lz;
+    t = lept_pow5_128[q - LEPT_POW5_MIN];
+    hi = lept_umul128(w, (uint64_t)t[0] << 32 | t[1], &lo);
+    if ((hi & 0x1FF) == 0x1FF) { /* the low bits may carry into the 55 we keep */
+        hi2 = lept_umul128(w, (uint64_t)t[2] << 32 | t[3], &lo2);
+        lo += hi2;
+        if (hi2 > lo)
+            hi++;
+    }
+    upper = (int)(hi >> 63);
+    shift = upper + 9;
+    m = hi >> shift;
+    p = 217706 * q; /* floor(q * log2(10) * 2^16) */
+    p = p >= 0 ? p >> 16 : -((-p + 65535) >> 16);
+    e2 = p + 63 + upper - lz + 1023;
+    if (e2 <= 0) { /* subnormal */
+        if (-e2 + 1 >= 64)
+            return 0;
+        m >>= -e2 + 1;
+        m += m & 1;
+        m >>= 1;
+        e2 = m < (uint64_t)1 << 52 ? 0 : 1;
+        return (uint64_t)e2 << 52 | (m & (((uint64_t)1 << 52) - 1));
+    }
+    /* exactly halfway between two doubles: round to even */
+    if (lo <= 1 && q >= -4 && q <= 23 && (m & 3) == 1 && (m << shift) == hi)
+        m &= ~(uint64_t)1;
+    m += m & 1;
+    m >>= 1;
+    if (m >= (uint64_t)2 << 52) {
+        m = (uint64_t)1 << 52;
+        e2++;
+    }
+    if (e2 >= 0x7FF)
+        return LEPT_DOUBLE_INF;
+    return (uint64_t)e2 << 52 | (m & (((uint64_t)1 << 52) - 1));
+}
+
+#define LEPT_BIGINT_LIMBS 128 /* 4096 bits, enough for 769 digits against a midpoint */
+
+typedef struct {
+    uint32_t d[LEPT_BIGINT_LIMBS];
+    int n;
+}lept_bigint;
+
+/* a = a * m + add */
+static void lept_bigint_mul(lept_bigint* a, uint32_t m, uint32_t add) {
+    uint64_t carry = add;
+    int i;
+    for (i = 0; i < a->n; i++) {
+        carry += (uint64_t)a->d[i] * m;
+        a->d[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (carry) {
+        assert(a->n < LEPT_BIGINT_LIMBS);
+        a->d[a->n++] = (uint32_t)carry;
+    }
+}
+
+static void lept_bigint_pow5(lept_bigint* a, long e) {
+    static const uint32_t pow5[] = { 1, 5, 25, 125, 625, 3125, 15625, 78125, 390625,
+        1953125, 9765625, 48828125, 244140625, 1220703125 };
+    for (; e >= 13; e -= 13)
+        lept_bigint_mul(a, pow5[13], 0);
+    lept_bigint_mul(a, pow5[e], 0);
+}
+
+static void lept_bigint_shl(lept_bigint* a, long s) {
+    int limbs = (int)(s / 32), bits = (int)(s % 32), i;
+    assert(a->n + limbs + 1 <= LEPT_BIGINT_LIMBS);
+    a->d[a->n] = 0;
+    for (i = a->n; i >= 0; i--) {
+        uint32_t x = a->d[i] << bits;
+        if (bits && i > 0)
+            x |= a->d[i - 1] >> (32 - bits);
+        a->d[i + limbs] = x;
+    }
+    for (i = 0; i < limbs; i++)
+        a->d[i] = 0;
+    a->n += limbs + 1;
+    while (a->n > 0 && a->d[a->n - 1] == 0)
+        a->n--;
+}
+
+static int lept_bigint_cmp(const lept_bigint* a, const lept_bigint* b) {
+    int i;
+    if (a->n != b->n)
+        return a->n < b->n ? -1 : 1;
+    for (i = a->n - 1; i >= 0; i--)
+        if (a->d[i] != b->d[i])
+            return a->d[i] < b->d[i] ? -1 : 1;
+    return 0;
+}
+
+/*
+ * The number in [json, end) is at least bits (the double nearest its first 19
+ * digits) and at most its successor. Compare all the digits, as an exact
+ * integer times 10^q, with the midpoint (2m + 1) * 2^(e - 1).
+ */
+static uint64_t lept_decimal_slow(const char* json, const char* end, uint64_t bits) {
+    lept_bigint x, y;
+    uint64_t m = bits & (((uint64_t)1 << 52) - 1), h;
+    long q = 0, ex, ey, e = (long)(bits >> 52);
+    int nd = 0, frac = 0, sticky = 0, cmp;
+    const char* p = json;
+    if (e == 0)
+        e = 1;
+    else
+        m |= (uint64_t)1 << 52;
+    e -= 1075;
+
+    /* 768 digits always decide; later ones only matter as a nonzero tail */
+    x.n = 0;
+    if (*p == '-')
+        p++;
+    for (; p < end && (ISDIGIT(*p) || *p == '.'); p++) {
+        if (*p == '.')
+            frac = 1;
+        else if (nd == 0 && *p == '0')
+            q -= frac;
+        else if (nd < 768) {
+            lept_bigint_mul(&x, 10, *p - '0');
+            nd++;
+            q -= frac;
+        }
+        else {
+            sticky |= *p != '0';
+            q += !frac;
+        }
+    }
+    if (sticky) {
+        lept_bigint_mul(&x, 10, 1);
+        q--;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        long exp = 0;
+        int neg = 0;
+        p++;
+        if (*p == '+' || *p == '-')
+            neg = *p++ == '-';
+        for (; p < end; p++)
+            if (exp < 100000)
+                exp = exp * 10 + (*p - '0');
+        q += neg ? -exp : exp;
+    }
+
+    h = 2 * m + 1;
+    y.d[0] = (uint32_t)h;
+    y.d[1] = (uint32_t)(h >> 32);
+    y.n = y.d[1] ? 2 : 1;
+    if (q >= 0)
+        lept_bigint_pow5(&x, q);
+    else
+        lept_bigint_pow5(&y, -q);
+    ex = q;
+    ey = e - 1;
+    if (ex > ey)
+        lept_bigint_shl(&x, ex - ey);
+    else
+        lept_bigint_shl(&y, ey - ex);
+    cmp = lept_bigint_cmp(&x, &y);
+    return cmp > 0 || (cmp == 0 && (m & 1)) ? bits + 1 : bits;
+}
+
+/*
+ * An integer literal with nd + q digits (the last one being last) is kept exact when it
+ * fits: negative ones in int64, others in int64 or else uint64. "-0" stays a double.
+ */
+static int lept_parse_integer(lept_value* v, int neg, uint64_t w, long q, int last) {
+    if (q == 1 && !neg && (w < UINT64_MAX / 10 || (w == UINT64_MAX / 10 && last <= (int)(UINT64_MAX % 10)))) {
+        w = w * 10 + last;
+        q = 0;
+    }
+    if (q != 0)
+        return 0;
+    if (neg) {
+        if (w == 0 || w > (uint64_t)INT64_MAX + 1)
+            return 0;
+        v->u.i64 = -(int64_t)(w - 1) - 1;
+        v->flags = LEPT_NUMBER_INT64;
+    }
+    else if (w <= INT64_MAX) {
+        v->u.i64 = (int64_t)w;
+        v->flags = LEPT_NUMBER_INT64;
+    }
+    else {
+        v->u.u64 = w;
+        v->flags = LEPT_NUMBER_UINT64;
+    }
+    return 1;
+}
+
 static int lept_parse_number(lept_context* c, lept_value* v) {
     const char* p = c->json;
-    if (*p == '-') p++;
-    if (*p == '0') p++;
+    uint64_t w = 0, bits;
+    long q = 0;
+    int nd = 0, truncated = 0, fraction = 0;
+    if (PEEK(c, p) == '-') p++;
+    if (PEEK(c, p) == '0') p++;
     else {
-        if (!ISDIGIT1TO9(*p)) return LEPT_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++);
+        if (!ISDIGIT1TO9(PEEK(c, p))) return LEPT_PARSE_INVALID_VALUE;
+        for (; ISDIGIT(PEEK(c, p)); p++) {
+            if (nd < 19) {
+                w = w * 10 + (*p - '0');
+                nd++;
+            }
+            else {
+                truncated |= *p != '0';
+                q++;
+            }
+        }
     }
-    if (*p == '.') {
+    if (PEEK(c, p) == '.') {
         p++;
-        if (!ISDIGIT(*p)) return LEPT_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++);
+        fraction = 1;
+        if (!ISDIGIT(PEEK(c, p))) return LEPT_PARSE_INVALID_VALUE;
+        for (; ISDIGIT(PEEK(c, p)); p++) {
+            if (nd < 19) {
+                if (w != 0 || *p != '0') {
+                    w = w * 10 + (*p - '0');
+                    nd++;
+                }
+                q--;
+            }
+            else
+                truncated |= *p != '0';
+        }
     }
-    if (*p == 'e' || *p == 'E') {
+    if (PEEK(c, p) == 'e' || PEEK(c, p) == 'E') {
+        long exp = 0;
+        int neg = 0;
         p++;
-        if (*p == '+' || *p == '-') p++;
-        if (!ISDIGIT(*p)) return LEPT_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++);
+        fraction = 1;
+        if (PEEK(c, p) == '+' || PEEK(c, p) == '-')
+            neg = *p++ == '-';
+        if (!ISDIGIT(PEEK(c, p))) return LEPT_PARSE_INVALID_VALUE;
+        for (; ISDIGIT(PEEK(c, p)); p++)
+            if (exp < 100000)
+                exp = exp * 10 + (*p - '0');
+        q += neg ? -exp : exp;
+    }
+    if (!fraction && lept_parse_integer(v, *c->json == '-', w, q, p[-1] - '0')) {
+        v->type = LEPT_NUMBER;
+        c->json = p;
+        return LEPT_PARSE_OK;
+    }
+    v->flags = LEPT_NUMBER_DOUBLE;
+    if (w == 0)
+        v->u.n = 0.0;
+    else if (!truncated && w <= (uint64_t)1 << 53 && q >= -22 && q <= 22)
+        v->u.n = q < 0 ? (double)w / lept_pow10[-q] : (double)w * lept_pow10[q];
+    else {
+        bits = lept_eisel_lemire(w, q);
+        if (truncated && bits != lept_eisel_lemire(w + 1, q))
+            bits = lept_decimal_slow(c->json, p, bits);
+        memcpy(&v->u.n, &bits, sizeof(double));
     }
-    errno = 0;
-    v->u.n = strtod(c->json, NULL);
-    if (errno == ERANGE && (v->u.n == HUGE_VAL || v->u.n == -HUGE_VAL))
+    if (v->u.n == HUGE_VAL)
         return LEPT_PARSE_NUMBER_TOO_BIG;
+    if (*c->json == '-')
+        v->u.n = -v->u.n;
     v->type = LEPT_NUMBER;
     c->json = p;
     return LEPT_PARSE_OK;
 }
 
-static const char* lept_parse_hex4(const char* p, unsigned* u) {
+static const char* lept_parse_hex4(const char* p, const char* end, unsigned* u) {
     int i;
     *u = 0;
+    if (end - p < 4)
+        return NULL;
     for (i = 0; i < 4; i++) {
         char ch = *p++;
         *u <<= 4;
@@ -110,75 +1040,178 @@ static const char* lept_parse_hex4(const char* p, unsigned* u) {
     return p;
 }
 
-static void lept_encode_utf8(lept_context* c, unsigned u) {
+/* Writes u as UTF-8 and returns the end. */
+static char* lept_encode_utf8(char* p, unsigned u) {
     if (u <= 0x7F) 
-        PUTC(c, u & 0xFF);
+        *p++ = u & 0xFF;
     else if (u <= 0x7FF) {
-        PUTC(c, 0xC0 | ((u >> 6) & 0xFF));
-        PUTC(c, 0x80 | ( u       & 0x3F));
+        *p++ = 0xC0 | ((u >> 6) & 0xFF);
+        *p++ = 0x80 | ( u       & 0x3F);
     }
     else if (u <= 0xFFFF) {
-        PUTC(c, 0xE0 | ((u >> 12) & 0xFF));
-        PUTC(c, 0x80 | ((u >>  6) & 0x3F));
-        PUTC(c, 0x80 | ( u        & 0x3F));
+        *p++ = 0xE0 | ((u >> 12) & 0xFF);
+        *p++ = 0x80 | ((u >>  6) & 0x3F);
+        *p++ = 0x80 | ( u        & 0x3F);
     }
     else {
         assert(u <= 0x10FFFF);
-        PUTC(c, 0xF0 | ((u >> 18) & 0xFF));
-        PUTC(c, 0x80 | ((u >> 12) & 0x3F));
-        PUTC(c, 0x80 | ((u >>  6) & 0x3F));
-        PUTC(c, 0x80 | ( u        & 0x3F));
+        *p++ = 0xF0 | ((u >> 18) & 0xFF);
+        *p++ = 0x80 | ((u >> 12) & 0x3F);
+        *p++ = 0x80 | ((u >>  6) & 0x3F);
+        *p++ = 0x80 | ( u        & 0x3F);
     }
+    return p;
 }
 
-#define STRING_ERROR(ret) do { c->top = head; return ret; } while(0)
+#define ESCAPE_ERROR(ret) do { *err = ret; return NULL; } while(0)
 
-static int lept_parse_string_raw(lept_context* c, char** str, size_t* len) {
-    size_t head = c->top;
+/*
+ * Decodes the escape sequence after a backslash at p into buf (4 bytes at
+ * most). Returns the input after it, or NULL with the error in *err.
+ */
+static const char* lept_parse_escape(const char* p, const char* end, char* buf, size_t* n, int* err) {
     unsigned u, u2;
+    char* q = buf;
+    switch (p < end ? *p++ : '\0') {
+        case '\"': *q++ = '\"'; break;
+        case '\\': *q++ = '\\'; break;
+        case '/':  *q++ = '/' ; break;
+        case 'b':  *q++ = '\b'; break;
+        case 'f':  *q++ = '\f'; break;
+        case 'n':  *q++ = '\n'; break;
+        case 'r':  *q++ = '\r'; break;
+        case 't':  *q++ = '\t'; break;
+        case 'u':
+            if (!(p = lept_parse_hex4(p, end, &u)))
+                ESCAPE_ERROR(LEPT_PARSE_INVALID_UNICODE_HEX);
+            if (u >= 0xD800 && u <= 0xDBFF) { /* surrogate pair */
+                if (end - p < 2 || p[0] != '\\' || p[1] != 'u')
+                    ESCAPE_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
+                p += 2;
+                if (!(p = lept_parse_hex4(p, end, &u2)))
+                    ESCAPE_ERROR(LEPT_PARSE_INVALID_UNICODE_HEX);
+                if (u2 < 0xDC00 || u2 > 0xDFFF)
+                    ESCAPE_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
+                u = (((u - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
+            }
+            q = lept_encode_utf8(q, u);
+            break;
+        default:
+            ESCAPE_ERROR(LEPT_PARSE_INVALID_STRING_ESCAPE);
+    }
+    *n = q - buf;
+    return p;
+}
+
+#define STRING_ERROR(ret) do { c->top = head; return ret; } while(0)
+
+/* Tests whether bits [b, e) of the dirty bitmap are all clear. */
+static int lept_index_clean(const uint64_t* dirty, size_t b, size_t e) {
+    size_t i = b >> 6, j = e >> 6;
+    uint64_t head = ~(uint64_t)0 << (b & 63), tail = ((uint64_t)1 << (e & 63)) - 1;
+    if (i == j)
+        return (dirty[i] & head & tail) == 0;
+    if (dirty[i] & head)
+        return 0;
+    for (i++; i < j; i++)
+        if (dirty[i])
+            return 0;
+    return (dirty[j] & tail) == 0;
+}
+
+/*
+ * Finds the closing quote of a string that needs no decoding, or returns NULL.
+ * The index holds both quotes of a string and marks escapes, so it can tell
+ * at once; view documents and SAX parses scan ahead for one instead.
+ */
+static const char* lept_parse_string_span(lept_context* c) {
+    const char* q;
+    if (c->index) {
+        size_t pos = c->json - c->base;
+        while (*c->index < pos)
+            c->index++;
+        if (c->index[0] != pos)
+            return NULL;
+        q = c->base + c->index[1];
+        if (q == c->end || *q != '\"' || !lept_index_clean(c->dirty, pos + 1, c->index[1]))
+            return NULL;
+        c->index += 2;
+        return q;
+    }
+    if (c->handler == NULL && (c->doc == NULL || !c->doc->views))
+        return NULL;
+    for (q = c->json + 1; q < c->end && (unsigned char)*q >= 0x20 && *q != '\"' && *q != '\\'; q++)
+        ;
+    return q < c->end && *q == '\"' ? q : NULL;
+}
+
+/* The decoded form of a string is never longer than its source, so it can overwrite it. */
+static int lept_parse_string_insitu(lept_context* c, const char** str, size_t* len) {
+    char* w = (char*)c->json + 1, buf[4];
+    const char* p = w;
+    size_t n;
+    int err;
+    *str = w;
+    for (;;) {
+        char ch;
+        if (p == c->end)
+            return LEPT_PARSE_MISS_QUOTATION_MARK;
+        switch (ch = *p++) {
+            case '\"':
+                *w = '\0';
+                *len = w - *str;
+                c->json = p;
+                return LEPT_PARSE_OK;
+            case '\\':
+                if (!(p = lept_parse_escape(p, c->end, buf, &n, &err)))
+                    return err;
+                memcpy(w, buf, n);
+                w += n;
+                break;
+            default:
+                if ((unsigned char)ch < 0x20)
+                    return LEPT_PARSE_INVALID_STRING_CHAR;
+                *w++ = ch;
+        }
+    }
+}
+
+/*
+ * *str points into the input when the string needed no decoding or was decoded
+ * in situ, else at the decoded bytes on the stack.
+ */
+static int lept_parse_string_raw(lept_context* c, const char** str, size_t* len) {
+    size_t head = c->top, n;
+    char buf[4];
+    int err;
     const char* p;
+    if ((p = lept_parse_string_span(c)) != NULL) {
+        *str = c->json + 1;
+        *len = p - *str;
+        c->json = p + 1;
+        if (c->insitu)
+            *(char*)p = '\0';
+        return LEPT_PARSE_OK;
+    }
+    if (c->insitu)
+        return lept_parse_string_insitu(c, str, len);
     EXPECT(c, '\"');
     p = c->json;
     for (;;) {
-        char ch = *p++;
-        switch (ch) {
+        char ch;
+        if (p == c->end)
+            STRING_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK);
+        switch (ch = *p++) {
             case '\"':
                 *len = c->top - head;
                 *str = lept_context_pop(c, *len);
                 c->json = p;
                 return LEPT_PARSE_OK;
             case '\\':
-                switch (*p++) {
-                    case '\"': PUTC(c, '\"'); break;
-                    case '\\': PUTC(c, '\\'); break;
-                    case '/':  PUTC(c, '/' ); break;
-                    case 'b':  PUTC(c, '\b'); break;
-                    case 'f':  PUTC(c, '\f'); break;
-                    case 'n':  PUTC(c, '\n'); break;
-                    case 'r':  PUTC(c, '\r'); break;
-                    case 't':  PUTC(c, '\t'); break;
-                    case 'u':
-                        if (!(p = lept_parse_hex4(p, &u)))
-                            STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_HEX);
-                        if (u >= 0xD800 && u <= 0xDBFF) { /* surrogate pair */
-                            if (*p++ != '\\')
-                                STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
-                            if (*p++ != 'u')
-                                STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
-                            if (!(p = lept_parse_hex4(p, &u2)))
-                                STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_HEX);
-                            if (u2 < 0xDC00 || u2 > 0xDFFF)
-                                STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
-                            u = (((u - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
-                        }
-                        lept_encode_utf8(c, u);
-                        break;
-                    default:
-                        STRING_ERROR(LEPT_PARSE_INVALID_STRING_ESCAPE);
-                }
+                if (!(p = lept_parse_escape(p, c->end, buf, &n, &err)))
+                    STRING_ERROR(err);
+                memcpy(lept_context_push(c, n), buf, n);
                 break;
-            case '\0':
-                STRING_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK);
             default:
                 if ((unsigned char)ch < 0x20)
                     STRING_ERROR(LEPT_PARSE_INVALID_STRING_CHAR);
@@ -187,157 +1220,1603 @@ static int lept_parse_string_raw(lept_context* c, char** str, size_t* len) {
     }
 }
 
+/* Whether a parsed string can stay where it lies: in the input in situ or in a view document, or for SAX. */
+static int lept_context_keeps(const lept_context* c, const char* s, const char* start) {
+    return c->handler != NULL || (s == start && (c->insitu || (c->doc != NULL && c->doc->views)));
+}
+
+/* Makes v the parsed string s: kept where it lies, or else copied inline or into new memory. */
+static void lept_context_string(lept_context* c, lept_value* v, const char* s, size_t len, const char* start) {
+    if (lept_context_keeps(c, s, start)) {
+        v->u.s = (char*)s;
+        v->size = len;
+        v->type = LEPT_STRING;
+        v->flags = 0;
+    }
+    else
+        lept_string_store(v, s, len, len > LEPT_INLINE_MAX ? (char*)lept_context_alloc(c, len + 1) : NULL);
+}
+
 static int lept_parse_string(lept_context* c, lept_value* v) {
     int ret;
-    char* s;
+    const char* s, *start = c->json + 1;
     size_t len;
-    if ((ret = lept_parse_string_raw(c, &s, &len)) == LEPT_PARSE_OK)
-        lept_set_string(v, s, len);
+    if ((ret = lept_parse_string_raw(c, &s, &len)) == LEPT_PARSE_OK) {
+        if (len > LEPT_LENGTH_MAX)
+            return LEPT_PARSE_SIZE_EXCEEDED;
+        lept_context_string(c, v, s, len, start);
+    }
     return ret;
 }
 
-static int lept_parse_value(lept_context* c, lept_value* v);
+/*
+ * Objects with a capacity of at least LEPT_OBJECT_HASH_MIN keep an open-addressing
+ * table of member indices right after the member array, in the same allocation.
+ * Slots hold index + 1 (0 is empty) and are rebuilt whenever members move.
+ */
 
-static int lept_parse_array(lept_context* c, lept_value* v) {
-    size_t i, size = 0;
-    int ret;
-    EXPECT(c, '[');
-    lept_parse_whitespace(c);
-    if (*c->json == ']') {
-        c->json++;
-        lept_set_array(v, 0);
-        return LEPT_PARSE_OK;
+#define LEPT_OBJECT_HASHED(v) ((v)->capacity >= LEPT_OBJECT_HASH_MIN)
+#define LEPT_OBJECT_TABLE(v)  ((size_t*)((v)->u.m + (v)->capacity))
+
+/* Power of two with at most 50% load. */
+static size_t lept_object_slots(size_t capacity) {
+    size_t n = 1;
+    while (n < capacity * 2)
+        n <<= 1;
+    return n;
+}
+
+static size_t lept_hash_key(const char* key, size_t klen) {
+    uint64_t h = UINT64_C(14695981039346656037);
+    size_t i;
+    for (i = 0; i < klen; i++)
+        h = (h ^ (unsigned char)key[i]) * UINT64_C(1099511628211);
+    return (size_t)(h ^ h >> 32);
+}
+
+/* Returns the slot holding key, or the empty slot where it would go. */
+static size_t* lept_object_slot(const lept_value* v, const char* key, size_t klen) {
+    size_t* table = LEPT_OBJECT_TABLE(v);
+    size_t mask = lept_object_slots(v->capacity) - 1, i = lept_hash_key(key, klen) & mask;
+    const lept_member* m;
+    for (;; i = (i + 1) & mask) {
+        if (table[i] == 0)
+            return &table[i];
+        m = &v->u.m[table[i] - 1];
+        if (m->klen == klen && (LEPT_KEY(m) == key || memcmp(LEPT_KEY(m), key, klen) == 0))
+            return &table[i];
     }
-    for (;;) {
-        lept_value e;
-        lept_init(&e);
-        if ((ret = lept_parse_value(c, &e)) != LEPT_PARSE_OK)
-            break;
-        memcpy(lept_context_push(c, sizeof(lept_value)), &e, sizeof(lept_value));
-        size++;
-        lept_parse_whitespace(c);
-        if (*c->json == ',') {
-            c->json++;
-            lept_parse_whitespace(c);
-        }
-        else if (*c->json == ']') {
-            c->json++;
-            lept_set_array(v, size);
-            memcpy(v->u.a.e, lept_context_pop(c, size * sizeof(lept_value)), size * sizeof(lept_value));
-            v->u.a.size = size;
-            return LEPT_PARSE_OK;
-        }
-        else {
-            ret = LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
-            break;
+}
+
+static void lept_object_rehash(lept_value* v) {
+    size_t i, *slot;
+    v->flags &= ~LEPT_DUPLICATES;
+    if (!LEPT_OBJECT_HASHED(v))
+        return;
+    memset(LEPT_OBJECT_TABLE(v), 0, lept_object_slots(v->capacity) * sizeof(size_t));
+    for (i = 0; i < v->size; i++)
+        if (*(slot = lept_object_slot(v, LEPT_KEY(&v->u.m[i]), v->u.m[i].klen)) == 0)
+            *slot = i + 1; /* on duplicate keys the first one wins, as in a linear scan */
+        else
+            v->flags |= LEPT_DUPLICATES;
+}
+
+/* The slot of member index, which has to be in the table. */
+static size_t* lept_object_slot_of(const lept_value* v, size_t index) {
+    size_t* table = LEPT_OBJECT_TABLE(v);
+    size_t mask = lept_object_slots(v->capacity) - 1;
+    const lept_member* m = &v->u.m[index];
+    size_t i = lept_hash_key(LEPT_KEY(m), m->klen) & mask;
+    while (table[i] != index + 1) {
+        assert(table[i] != 0);
+        i = (i + 1) & mask;
+    }
+    return &table[i];
+}
+
+/* Empties a slot, moving back the later ones of its run that would no longer be found. */
+static void lept_object_unslot(lept_value* v, size_t* slot) {
+    size_t* table = LEPT_OBJECT_TABLE(v);
+    size_t mask = lept_object_slots(v->capacity) - 1, i = slot - table, j, home;
+    const lept_member* m;
+    for (j = (i + 1) & mask; table[j] != 0; j = (j + 1) & mask) {
+        m = &v->u.m[table[j] - 1];
+        home = lept_hash_key(LEPT_KEY(m), m->klen) & mask;
+        if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+            table[i] = table[j];
+            i = j;
         }
     }
-    /* Pop and free values on the stack */
-    for (i = 0; i < size; i++)
-        lept_free((lept_value*)lept_context_pop(c, sizeof(lept_value)));
-    return ret;
+    table[i] = 0;
 }
 
-static int lept_parse_object(lept_context* c, lept_value* v) {
-    size_t i, size;
-    lept_member m;
-    int ret;
-    EXPECT(c, '{');
-    lept_parse_whitespace(c);
-    if (*c->json == '}') {
-        c->json++;
-        lept_set_object(v, 0);
-        return LEPT_PARSE_OK;
+static size_t lept_object_bytes(size_t capacity) {
+    size_t size = capacity * sizeof(lept_member);
+    if (capacity >= LEPT_OBJECT_HASH_MIN)
+        size += lept_object_slots(capacity) * sizeof(size_t);
+    return size;
+}
+
+/* Resizes the member array (and table) to capacity and rebuilds the table. */
+static void lept_object_realloc(lept_value* v, size_t capacity) {
+    size_t old_size = lept_object_bytes(v->capacity);
+    if (capacity == 0) {
+        LEPT_FREE(&lept_allocator_default, v->u.m, old_size);
+        v->u.m = NULL;
     }
-    m.k = NULL;
-    size = 0;
-    for (;;) {
-        char* str;
-        lept_init(&m.v);
-        /* parse key */
-        if (*c->json != '"') {
-            ret = LEPT_PARSE_MISS_KEY;
-            break;
-        }
-        if ((ret = lept_parse_string_raw(c, &str, &m.klen)) != LEPT_PARSE_OK)
-            break;
-        memcpy(m.k = (char*)malloc(m.klen + 1), str, m.klen);
-        m.k[m.klen] = '\0';
-        /* parse ws colon ws */
-        lept_parse_whitespace(c);
-        if (*c->json != ':') {
-            ret = LEPT_PARSE_MISS_COLON;
-            break;
-        }
-        c->json++;
-        lept_parse_whitespace(c);
-        /* parse value */
-        if ((ret = lept_parse_value(c, &m.v)) != LEPT_PARSE_OK)
-            break;
-        memcpy(lept_context_push(c, sizeof(lept_member)), &m, sizeof(lept_member));
-        size++;
-        m.k = NULL; /* ownership is transferred to member on stack */
-        /* parse ws [comma | right-curly-brace] ws */
-        lept_parse_whitespace(c);
-        if (*c->json == ',') {
-            c->json++;
-            lept_parse_whitespace(c);
-        }
-        else if (*c->json == '}') {
-            c->json++;
-            lept_set_object(v, size);
-            memcpy(v->u.o.m, lept_context_pop(c, sizeof(lept_member) * size), sizeof(lept_member) * size);
-            v->u.o.size = size;
-            return LEPT_PARSE_OK;
+    else
+        v->u.m = (lept_member*)LEPT_REALLOC(&lept_allocator_default, v->u.m, old_size, lept_object_bytes(capacity));
+    v->capacity = capacity;
+    lept_object_rehash(v);
+}
+
+/* The heap storage of a string, array or object: NULL for an inline string or a container without any. */
+static char* lept_payload(const lept_value* v) {
+    if (v->type == LEPT_STRING)
+        return v->flags & LEPT_INLINE ? NULL : v->u.s;
+    return v->type == LEPT_ARRAY ? (char*)v->u.e : (char*)v->u.m;
+}
+
+static void lept_set_payload(lept_value* v, char* p) {
+    if (v->type == LEPT_STRING)
+        v->u.s = p;
+    else if (v->type == LEPT_ARRAY)
+        v->u.e = (lept_value*)p;
+    else
+        v->u.m = (lept_member*)p;
+}
+
+static size_t lept_payload_bytes(const lept_value* v) {
+    if (v->type == LEPT_STRING)
+        return v->size + 1;
+    return v->type == LEPT_ARRAY ? v->capacity * sizeof(lept_value) : lept_object_bytes(v->capacity);
+}
+
+typedef struct {
+    const char* key;    /* NULL for an empty slot */
+    size_t klen, hash;
+}lept_intern_entry;
+
+/* Keys sit in the arena of keys, never moving; the slots are a power of two, at most half full. */
+struct lept_intern {
+    lept_document keys;
+    lept_intern_entry* slots;
+    size_t capacity, count;
+    size_t id;  /* never reused, unlike the address, so parsers can tell pools apart */
+    LEPT_LOCK lock;
+};
+
+static lept_refcount lept_intern_ids;
+
+lept_intern* lept_intern_new(const lept_allocator* a) {
+    lept_intern* t = (lept_intern*)LEPT_MALLOC(a != NULL ? a : &lept_allocator_default, sizeof(lept_intern));
+    lept_document_init(&t->keys);
+    t->keys.allocator = a;
+    t->slots = NULL;
+    t->capacity = t->count = 0;
+    t->id = (size_t)LEPT_REF_INC(&lept_intern_ids);
+    LEPT_LOCK_INIT(&t->lock);
+    return t;
+}
+
+static void lept_intern_grow(lept_intern* t) {
+    const lept_allocator* a = lept_document_allocator(&t->keys);
+    size_t capacity = t->capacity > 0 ? t->capacity * 2 : 64, i, j;
+    lept_intern_entry* slots = (lept_intern_entry*)LEPT_MALLOC(a, capacity * sizeof(lept_intern_entry));
+    for (j = 0; j < capacity; j++)
+        slots[j].key = NULL;
+    for (i = 0; i < t->capacity; i++)
+        if (t->slots[i].key != NULL) {
+            for (j = t->slots[i].hash & (capacity - 1); slots[j].key != NULL; j = (j + 1) & (capacity - 1))
+                ;
+            slots[j] = t->slots[i];
         }
-        else {
-            ret = LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    if (t->capacity > 0)
+        LEPT_FREE(a, t->slots, t->capacity * sizeof(lept_intern_entry));
+    t->slots = slots;
+    t->capacity = capacity;
+}
+
+const char* lept_intern_key(lept_intern* t, const char* key, size_t klen) {
+    size_t hash, i;
+    lept_intern_entry* e;
+    const char* ret;
+    char* p;
+    assert(t != NULL && key != NULL);
+    hash = lept_hash_key(key, klen);
+    LEPT_LOCK_ACQUIRE(&t->lock);
+    if (t->count * 2 >= t->capacity)
+        lept_intern_grow(t);
+    for (i = hash & (t->capacity - 1); (e = &t->slots[i])->key != NULL; i = (i + 1) & (t->capacity - 1))
+        if (e->hash == hash && e->klen == klen && memcmp(e->key, key, klen) == 0)
             break;
-        }
+    if (e->key == NULL) {
+        p = (char*)lept_document_alloc(&t->keys, klen + 1);
+        if (klen > 0)
+            memcpy(p, key, klen);
+        p[klen] = '\0';
+        e->key = p;
+        e->klen = klen;
+        e->hash = hash;
+        t->count++;
     }
-    /* Pop and free members on the stack */
-    free(m.k);
-    for (i = 0; i < size; i++) {
-        lept_member* m = (lept_member*)lept_context_pop(c, sizeof(lept_member));
-        free(m->k);
-        lept_free(&m->v);
-    }
-    v->type = LEPT_NULL;
+    ret = e->key;   /* the slots may move once the lock is released, the key never does */
+    LEPT_LOCK_RELEASE(&t->lock);
     return ret;
 }
 
-static int lept_parse_value(lept_context* c, lept_value* v) {
-    switch (*c->json) {
-        case 't':  return lept_parse_literal(c, v, "true", LEPT_TRUE);
-        case 'f':  return lept_parse_literal(c, v, "false", LEPT_FALSE);
-        case 'n':  return lept_parse_literal(c, v, "null", LEPT_NULL);
-        default:   return lept_parse_number(c, v);
-        case '"':  return lept_parse_string(c, v);
-        case '[':  return lept_parse_array(c, v);
-        case '{':  return lept_parse_object(c, v);
-        case '\0': return LEPT_PARSE_EXPECT_VALUE;
+size_t lept_intern_count(lept_intern* t) {
+    size_t count;
+    assert(t != NULL);
+    LEPT_LOCK_ACQUIRE(&t->lock);
+    count = t->count;
+    LEPT_LOCK_RELEASE(&t->lock);
+    return count;
+}
+
+/* The pooled copy of a key, found among the parser's recent keys without the lock when it can be. */
+static const char* lept_parser_intern(lept_parser* p, const char* key, size_t klen) {
+    size_t i = (klen * 31 + (unsigned char)key[0] + (unsigned char)key[klen / 2] * 7 +
+        (unsigned char)key[klen - 1] * 3) % LEPT_PARSER_RECENT;
+    assert(klen > 0);
+    if (p->intern_id != p->intern->id) {
+        memset(p->recent_klen, 0, sizeof(p->recent_klen));  /* 0 marks an empty entry, as pooled keys here are long */
+        p->intern_id = p->intern->id;
+    }
+    if (p->recent_klen[i] != klen || memcmp(p->recent[i], key, klen) != 0) {
+        p->recent[i] = lept_intern_key(p->intern, key, klen);
+        p->recent_klen[i] = klen;
+    }
+    return p->recent[i];
+}
+
+void lept_intern_free(lept_intern* t) {
+    const lept_allocator* a;
+    if (t == NULL)
+        return;
+    a = lept_document_allocator(&t->keys);
+    if (t->capacity > 0)
+        LEPT_FREE(a, t->slots, t->capacity * sizeof(lept_intern_entry));
+    lept_document_free(&t->keys);
+    LEPT_LOCK_FREE(&t->lock);
+    LEPT_FREE(a, t, sizeof(lept_intern));
+}
+
+/*
+ * Arrays and objects being parsed sit on the stack behind a frame, their
+ * elements or members pushed after it as they complete, so nesting costs no
+ * C stack. With a handler the frames only count, and values become events.
+ */
+
+#define LEPT_FRAME_NONE ((size_t)-1)
+#define LEPT_FRAME(c)   ((lept_frame*)((c)->stack + (c)->frame))
+
+#define LEPT_SAX(h, cb, args) ((h)->cb == NULL || (h)->cb args ? LEPT_PARSE_OK : LEPT_PARSE_ABORTED)
+
+typedef struct {
+    size_t parent;  /* offset of the enclosing frame, or LEPT_FRAME_NONE */
+    size_t size;    /* complete elements or members */
+    lept_type type;
+    int pending;    /* object: a member with a key but no value yet is on top */
+}lept_frame;
+
+static int lept_context_open(lept_context* c, lept_type type) {
+    size_t offset = c->top;
+    const lept_handler* h = c->handler;
+    lept_frame* f;
+    if (c->depth == c->max_depth)
+        return LEPT_PARSE_DEPTH_EXCEEDED;
+    f = (lept_frame*)lept_context_push(c, sizeof(lept_frame));
+    f->parent = c->frame;
+    f->size = 0;
+    f->type = type;
+    f->pending = 0;
+    c->frame = offset;
+    c->depth++;
+    if (h == NULL)
+        return LEPT_PARSE_OK;
+    return type == LEPT_ARRAY ? LEPT_SAX(h, on_start_array, (h->user)) : LEPT_SAX(h, on_start_object, (h->user));
+}
+
+/* Starts a member of the innermost object, keeping its key k as lept_context_string() would. */
+static int lept_context_key(lept_context* c, const char* k, size_t klen, const char* start) {
+    const lept_handler* h = c->handler;
+    lept_member m;
+    if (h != NULL)
+        return LEPT_SAX(h, on_key, (h->user, k, klen));
+    if (lept_context_keeps(c, k, start)) {
+        m.k.p = (char*)k;
+        m.klen = klen;
+        LEPT_KEY_TAG(&m) = LEPT_KEY_HEAP;
+    }
+    else if (c->parser != NULL && c->parser->intern != NULL && klen >= LEPT_KEY_INLINE - 1) {
+        m.k.p = (char*)lept_parser_intern(c->parser, k, klen);
+        m.klen = klen;
+        LEPT_KEY_TAG(&m) = LEPT_KEY_SHARED;
+    }
+    else
+        lept_key_store(&m, k, klen, klen >= LEPT_KEY_INLINE - 1 ? (char*)lept_context_alloc(c, klen + 1) : NULL);
+    lept_init(&m.v);
+    /* only now, as k may lie on the stack where the member goes */
+    memcpy(lept_context_push(c, sizeof(lept_member)), &m, sizeof(lept_member));
+    LEPT_FRAME(c)->pending = 1;
+    return LEPT_PARSE_OK;
+}
+
+/* Hands a complete value to the innermost array or object. */
+static void lept_context_add(lept_context* c, const lept_value* e) {
+    lept_frame* f = LEPT_FRAME(c);
+    f->size++;
+    if (c->handler != NULL)
+        return;
+    if (f->type == LEPT_ARRAY)
+        memcpy(lept_context_push(c, sizeof(lept_value)), e, sizeof(lept_value));
+    else {
+        ((lept_member*)(c->stack + c->top) - 1)->v = *e;
+        LEPT_FRAME(c)->pending = 0;
+    }
+}
+
+/* Pops the innermost array or object into e, or sends its end event. */
+static int lept_context_close(lept_context* c, lept_value* e) {
+    lept_frame f = *LEPT_FRAME(c);
+    const lept_handler* h = c->handler;
+    if (h == NULL && f.size > LEPT_CAPACITY_MAX)
+        return LEPT_PARSE_SIZE_EXCEEDED;
+    lept_init(e);
+    c->depth--;
+    if (h != NULL) {
+        c->top = c->frame;
+        c->frame = f.parent;
+        e->type = f.type;
+        return f.type == LEPT_ARRAY ?
+            LEPT_SAX(h, on_end_array, (h->user, f.size)) : LEPT_SAX(h, on_end_object, (h->user, f.size));
+    }
+    if (f.size == 0) {
+        if (f.type == LEPT_ARRAY)
+            lept_set_array(e, 0);
+        else
+            lept_set_object(e, 0);
+    }
+    else if (f.type == LEPT_ARRAY) {
+        e->u.e = (lept_value*)lept_context_alloc(c, f.size * sizeof(lept_value));
+        memcpy(e->u.e, lept_context_pop(c, f.size * sizeof(lept_value)), f.size * sizeof(lept_value));
+        e->size = e->capacity = f.size;
+        e->type = LEPT_ARRAY;
+    }
+    else {
+        e->u.m = (lept_member*)lept_context_alloc(c, lept_object_bytes(f.size));
+        memcpy(e->u.m, lept_context_pop(c, f.size * sizeof(lept_member)), f.size * sizeof(lept_member));
+        e->size = e->capacity = f.size;
+        e->type = LEPT_OBJECT;
+        lept_object_rehash(e);
+    }
+    if (c->doc != NULL)
+        e->flags |= LEPT_BORROWED;
+    c->top = c->frame;
+    c->frame = f.parent;
+    return LEPT_PARSE_OK;
+}
+
+/* Frees what was built before an error, innermost container first. */
+static void lept_context_unwind(lept_context* c) {
+    while (c->frame != LEPT_FRAME_NONE) {
+        lept_frame f = *LEPT_FRAME(c);
+        char* base = c->stack + c->frame + sizeof(lept_frame);
+        size_t i;
+        if (c->handler == NULL && f.type == LEPT_ARRAY)
+            for (i = 0; i < f.size; i++)
+                lept_context_discard(c, (lept_value*)base + i);
+        else if (c->handler == NULL)
+            for (i = 0; i < f.size + f.pending; i++) {
+                lept_member* m = (lept_member*)base + i;
+                if (LEPT_KEY_TAG(m) == LEPT_KEY_HEAP)
+                    lept_context_free(c, m->k.p, m->klen + 1);
+                lept_context_discard(c, &m->v);
+            }
+        c->top = c->frame;
+        c->frame = f.parent;
+    }
+    c->depth = 0;
+}
+
+static int lept_sax_scalar(lept_context* c, const lept_value* v) {
+    const lept_handler* h = c->handler;
+    switch (v->type) {
+        case LEPT_NULL:   return LEPT_SAX(h, on_null, (h->user));
+        case LEPT_NUMBER: return LEPT_SAX(h, on_number, (h->user, v));
+        case LEPT_STRING: return LEPT_SAX(h, on_string, (h->user, LEPT_STRING(v), v->size));
+        default:          return LEPT_SAX(h, on_bool, (h->user, v->type == LEPT_TRUE));
+    }
+}
+
+/* Reads a member key and the colon after it. */
+static int lept_parse_key(lept_context* c) {
+    const char* str, *start = c->json + 1;
+    size_t klen;
+    int ret;
+    if (PEEK(c, c->json) != '"')
+        return LEPT_PARSE_MISS_KEY;
+    if ((ret = lept_parse_string_raw(c, &str, &klen)) != LEPT_PARSE_OK)
+        return ret;
+    if ((ret = lept_context_key(c, str, klen, start)) != LEPT_PARSE_OK)
+        return ret;
+    lept_parse_whitespace(c);
+    if (PEEK(c, c->json) != ':')
+        return LEPT_PARSE_MISS_COLON;
+    c->json++;
+    lept_parse_whitespace(c);
+    return LEPT_PARSE_OK;
+}
+
+/*
+ * Opens an array or object. An empty one is complete in e at once; otherwise
+ * e stays null and the first value (after the first key) is up next.
+ */
+static int lept_parse_open(lept_context* c, lept_value* e) {
+    lept_type type = *c->json == '[' ? LEPT_ARRAY : LEPT_OBJECT;
+    int ret;
+    if ((ret = lept_context_open(c, type)) != LEPT_PARSE_OK)
+        return ret;
+    c->json++;
+    lept_parse_whitespace(c);
+    if (PEEK(c, c->json) == (type == LEPT_ARRAY ? ']' : '}')) {
+        c->json++;
+        return lept_context_close(c, e);
     }
+    return type == LEPT_OBJECT ? lept_parse_key(c) : LEPT_PARSE_OK;
+}
+
+/* After a complete value, a comma or the closing bracket of the innermost container. */
+static int lept_parse_next(lept_context* c, lept_value* e) {
+    lept_type type = LEPT_FRAME(c)->type;
+    lept_context_add(c, e);
+    lept_parse_whitespace(c);
+    if (PEEK(c, c->json) == ',') {
+        c->json++;
+        lept_parse_whitespace(c);
+        lept_init(e);
+        return type == LEPT_OBJECT ? lept_parse_key(c) : LEPT_PARSE_OK;
+    }
+    if (PEEK(c, c->json) == (type == LEPT_ARRAY ? ']' : '}')) {
+        c->json++;
+        return lept_context_close(c, e);
+    }
+    return type == LEPT_ARRAY ? LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+}
+
+/*
+ * Parses one value per turn. A complete one is handed up, closing each
+ * container it completes, until a comma or an open container asks for the
+ * next value; e stays null while a value is still to come.
+ */
+static int lept_parse_value(lept_context* c, lept_value* v) {
+    lept_value e;
+    int ret;
+    for (;;) {
+        lept_init(&e);
+        switch (PEEK(c, c->json)) {
+            case 't':  ret = lept_parse_literal(c, &e, "true", LEPT_TRUE); break;
+            case 'f':  ret = lept_parse_literal(c, &e, "false", LEPT_FALSE); break;
+            case 'n':  ret = lept_parse_literal(c, &e, "null", LEPT_NULL); break;
+            default:   ret = lept_parse_number(c, &e); break;
+            case '"':  ret = lept_parse_string(c, &e); break;
+            case '[':
+            case '{':
+                if ((ret = lept_parse_open(c, &e)) == LEPT_PARSE_OK && e.type == LEPT_NULL)
+                    continue;
+                break;
+            case '\0':
+                ret = c->json == c->end ? LEPT_PARSE_EXPECT_VALUE : LEPT_PARSE_INVALID_VALUE;
+                break;
+        }
+        if (ret == LEPT_PARSE_OK && c->handler != NULL && e.type != LEPT_ARRAY && e.type != LEPT_OBJECT)
+            ret = lept_sax_scalar(c, &e);
+        if (c->doc != NULL)
+            e.flags |= LEPT_BORROWED;
+        while (ret == LEPT_PARSE_OK && c->frame != LEPT_FRAME_NONE) {
+            if ((ret = lept_parse_next(c, &e)) == LEPT_PARSE_OK && e.type == LEPT_NULL)
+                break;
+        }
+        if (ret != LEPT_PARSE_OK) {
+            lept_context_unwind(c);
+            return ret;
+        }
+        if (c->frame == LEPT_FRAME_NONE) {
+            *v = e;
+            return LEPT_PARSE_OK;
+        }
+    }
+}
+
+static int lept_parse_root(lept_context* c, lept_value* v) {
+    int ret;
+    lept_init(v);
+    lept_parse_whitespace(c);
+    if ((ret = lept_parse_value(c, v)) == LEPT_PARSE_OK) {
+        lept_parse_whitespace(c);
+        if (c->json != c->end) {
+            lept_context_discard(c, v);
+            lept_init(v);
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    assert(c->top == 0);
+    return ret;
 }
 
 int lept_parse(lept_value* v, const char* json) {
+    assert(json != NULL);
+    return lept_parse_n(v, json, strlen(json));
+}
+
+int lept_parse_n(lept_value* v, const char* json, size_t len) {
+    lept_parser p;
+    int ret;
+    lept_parser_init(&p);
+    ret = lept_parser_parse_n(&p, v, json, len);
+    lept_parser_free(&p);
+    return ret;
+}
+
+int lept_document_parse(lept_document* d, const char* json) {
+    assert(json != NULL);
+    return lept_document_parse_n(d, json, strlen(json));
+}
+
+int lept_document_parse_n(lept_document* d, const char* json, size_t len) {
+    lept_parser p;
+    int ret;
+    assert(d != NULL);
+    lept_parser_init(&p);
+    p.allocator = d->allocator;
+    ret = lept_parser_parse_document_n(&p, d, json, len);
+    lept_parser_free(&p);
+    return ret;
+}
+
+int lept_document_parse_insitu(lept_document* d, char* json) {
+    lept_parser p;
+    int ret;
+    assert(d != NULL);
+    lept_parser_init(&p);
+    p.allocator = d->allocator;
+    ret = lept_parser_parse_insitu(&p, d, json);
+    lept_parser_free(&p);
+    return ret;
+}
+
+int lept_document_parse_file(lept_document* d, const char* path) {
+    lept_parser p;
+    int ret;
+    assert(d != NULL);
+    lept_parser_init(&p);
+    p.allocator = d->allocator;
+    ret = lept_parser_parse_file(&p, d, path);
+    lept_parser_free(&p);
+    return ret;
+}
+
+void lept_document_free(lept_document* d) {
+    lept_chunk* k;
+    assert(d != NULL);
+    lept_unmap_file(lept_document_allocator(d), d->file, d->file_size);
+    d->file = NULL;
+    d->file_size = 0;
+    while ((k = d->chunks) != NULL) {
+        d->chunks = k->next;
+        LEPT_FREE(lept_document_allocator(d), k, LEPT_ALIGN(sizeof(lept_chunk)) + k->size);
+    }
+    lept_init(&d->root);
+}
+
+/*
+ * Structural index (stage 1 of lept_parse_indexed).
+ *
+ * Each 64-byte block is classified with SIMD compares into bitmaps of
+ * backslashes, quotes, structural characters, whitespace and control
+ * characters. Bit tricks then find the escaped characters, the string regions
+ * (prefix xor of the unescaped quotes) and the first character of every
+ * scalar. The offsets of all structural characters outside strings, all
+ * unescaped quotes and all scalar starts form the index, which ends with the
+ * input length as a sentinel. A second bitmap marks backslashes and control
+ * characters inside strings.
+ *
+ * Stage 2 is the normal parser: it jumps over whitespace to the next indexed
+ * token, and copies a string in one go when the dirty bitmap is clear between
+ * its quotes. Anything else takes the scalar path, so errors are unchanged.
+ */
+
+typedef struct {
+    const lept_allocator* allocator;
+    unsigned* e;
+    size_t size, capacity;
+    uint64_t* dirty;    /* one word per block */
+    uint64_t escaped;   /* first character of the next block is escaped */
+    uint64_t in_string; /* all ones if the last block ended inside a string */
+    uint64_t scalar;    /* last block ended with a scalar character */
+    size_t scalars;     /* entries that start a number or literal */
+}lept_index;
+
+#ifndef LEPT_INDEX_SAMPLE
+#define LEPT_INDEX_SAMPLE 1024      /* bytes indexed before deciding whether the rest is worth it */
+#endif
+#ifndef LEPT_INDEX_SCALAR_SHARE
+#define LEPT_INDEX_SCALAR_SHARE 4   /* the index is skipped when more than 1 in this many entries is a scalar */
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LEPT_INDEX_X86
+#define LEPT_TARGET(isa) __attribute__((target(isa)))
+
+static void lept_index_block(lept_index* x, size_t pos,
+    uint64_t bs, uint64_t qt, uint64_t op, uint64_t ws, uint64_t ctrl)
+{
+    const uint64_t even = UINT64_C(0x5555555555555555);
+    uint64_t escape, follows, odd_starts, even_starts, escaped, quote, str, scalar, starts, tok;
+    unsigned* p;
+
+    /* characters preceded by an odd-length run of backslashes */
+    escape = bs & ~x->escaped;
+    follows = (escape << 1) | x->escaped;
+    odd_starts = escape & ~even & ~follows;
+    even_starts = odd_starts + escape;
+    x->escaped = even_starts < escape; /* carry out of the addition */
+    escaped = (even ^ (even_starts << 1)) & follows;
+
+    /* string regions include the opening quote but not the closing one */
+    quote = qt & ~escaped;
+    str = quote;
+    str ^= str << 1;
+    str ^= str << 2;
+    str ^= str << 4;
+    str ^= str << 8;
+    str ^= str << 16;
+    str ^= str << 32;
+    str ^= x->in_string;
+    x->in_string = 0 - (str >> 63);
+    x->dirty[pos >> 6] = (bs | ctrl) & str;
+
+    scalar = ~(op | ws | quote | str);
+    starts = scalar & ~((scalar << 1) | x->scalar);
+    x->scalars += __builtin_popcountll(starts);
+    tok = (op & ~str) | quote | starts;
+    x->scalar = scalar >> 63;
+
+    if (x->size + 64 >= x->capacity) {
+        size_t old_size = x->capacity * sizeof(unsigned);
+        x->capacity += x->capacity >> 1;
+        x->e = (unsigned*)LEPT_REALLOC(x->allocator, x->e, old_size, x->capacity * sizeof(unsigned));
+    }
+    for (p = x->e + x->size; tok; tok &= tok - 1)
+        *p++ = (unsigned)pos + __builtin_ctzll(tok);
+    x->size = p - x->e;
+}
+
+LEPT_TARGET("avx2") static void lept_index_avx2(lept_index* x, const char* json, size_t i, size_t len) {
+    const __m256i quote = _mm256_set1_epi8('\"'), backslash = _mm256_set1_epi8('\\');
+    const __m256i lower = _mm256_set1_epi8(0x20), open = _mm256_set1_epi8('{'), close = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':'), comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t');
+    const __m256i lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+    const __m256i ctrl = _mm256_set1_epi8(0x1F);
+    char tail[64];
+    for (; i < len; i += 64) {
+        const char* p = json + i;
+        uint64_t m[5][2];
+        int j;
+        if (len - i < 64) {
+            memset(tail, ' ', 64);
+            memcpy(tail, p, len - i);
+            p = tail;
+        }
+        for (j = 0; j < 2; j++) {
+            __m256i b = _mm256_loadu_si256((const __m256i*)(p + j * 32));
+            __m256i l = _mm256_or_si256(b, lower); /* '[' -> '{', ']' -> '}' */
+            __m256i o = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(l, open), _mm256_cmpeq_epi8(l, close)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(b, colon), _mm256_cmpeq_epi8(b, comma)));
+            __m256i w = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(b, space), _mm256_cmpeq_epi8(b, tab)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(b, lf), _mm256_cmpeq_epi8(b, cr)));
+            m[0][j] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, backslash));
+            m[1][j] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, quote));
+            m[2][j] = (uint32_t)_mm256_movemask_epi8(o);
+            m[3][j] = (uint32_t)_mm256_movemask_epi8(w);
+            m[4][j] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(b, ctrl), b));
+        }
+        lept_index_block(x, i,
+            m[0][0] | m[0][1] << 32, m[1][0] | m[1][1] << 32, m[2][0] | m[2][1] << 32,
+            m[3][0] | m[3][1] << 32, m[4][0] | m[4][1] << 32);
+    }
+}
+
+LEPT_TARGET("sse4.2") static void lept_index_sse42(lept_index* x, const char* json, size_t i, size_t len) {
+    const __m128i quote = _mm_set1_epi8('\"'), backslash = _mm_set1_epi8('\\'), ctrl = _mm_set1_epi8(0x1F);
+    const __m128i ops = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i wss = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    char tail[64];
+    for (; i < len; i += 64) {
+        const char* p = json + i;
+        uint64_t m[5] = { 0, 0, 0, 0, 0 };
+        int j;
+        if (len - i < 64) {
+            memset(tail, ' ', 64);
+            memcpy(tail, p, len - i);
+            p = tail;
+        }
+        for (j = 0; j < 4; j++) {
+            __m128i b = _mm_loadu_si128((const __m128i*)(p + j * 16));
+            m[0] |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(b, backslash)) << (j * 16);
+            m[1] |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(b, quote)) << (j * 16);
+            m[2] |= (uint64_t)(unsigned)_mm_cvtsi128_si32(_mm_cmpestrm(ops, 6, b, 16,
+                _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK)) << (j * 16);
+            m[3] |= (uint64_t)(unsigned)_mm_cvtsi128_si32(_mm_cmpestrm(wss, 4, b, 16,
+                _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK)) << (j * 16);
+            m[4] |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(b, ctrl), b)) << (j * 16);
+        }
+        lept_index_block(x, i, m[0], m[1], m[2], m[3], m[4]);
+    }
+}
+#endif
+
+#ifdef LEPT_INDEX_X86
+/*
+ * Stage 2 gains on strings and whitespace it can jump over; numbers and
+ * literals it parses as the scalar path does, so input made mostly of them
+ * only pays for stage 1.
+ */
+static int lept_index_pays(const lept_index* x) {
+    return x->scalars * LEPT_INDEX_SCALAR_SHARE <= x->size;
+}
+
+/* Grows the parser's index buffers to fit len bytes of input, and at least count entries; what they held is dropped. */
+static void lept_index_reserve(lept_parser* p, const lept_allocator* a, size_t len, size_t count) {
+    if (count < len / 4)
+        count = len / 4;
+    if (p->index_capacity < count + 128) {
+        LEPT_FREE(a, p->index, p->index_capacity * sizeof(unsigned));
+        p->index_capacity = count + 128;
+        p->index = (unsigned*)LEPT_MALLOC(a, p->index_capacity * sizeof(unsigned));
+    }
+    if (p->dirty_capacity < len / 64 + 1) {
+        LEPT_FREE(a, p->dirty, p->dirty_capacity * sizeof(uint64_t));
+        p->dirty_capacity = len / 64 + 1;
+        p->dirty = (uint64_t*)LEPT_MALLOC(a, p->dirty_capacity * sizeof(uint64_t));
+    }
+}
+#endif
+
+/*
+ * Indexes the first LEPT_INDEX_SAMPLE bytes into the buffers x comes with,
+ * which the caller sizes for them, then the rest into p's buffers. Returns 0
+ * when the CPU has neither AVX2 nor SSE4.2, or when p->index_min turns away
+ * the input, so the caller takes the scalar path.
+ */
+static int lept_build_index(lept_parser* p, lept_index* x, const char* json, size_t len) {
+#ifdef LEPT_INDEX_X86
+    void (*build)(lept_index*, const char*, size_t, size_t);
+    size_t sample = len < LEPT_INDEX_SAMPLE ? len : LEPT_INDEX_SAMPLE;
+    if (__builtin_cpu_supports("avx2"))
+        build = lept_index_avx2;
+    else if (__builtin_cpu_supports("sse4.2"))
+        build = lept_index_sse42;
+    else
+        return 0;
+    if (len >= UINT_MAX || (p->index_min > 0 && len < p->index_min))
+        return 0;
+    x->size = x->scalars = 0;
+    x->escaped = x->in_string = x->scalar = 0;
+    x->dirty[sample / 64] = 0;
+    /* the first block tells most input apart, the rest of the sample makes sure */
+    build(x, json, 0, sample < 64 ? sample : 64);
+    if (p->index_min > 0 && !lept_index_pays(x))
+        return 0;
+    if (sample > 64) {
+        build(x, json, 64, sample);
+        if (p->index_min > 0 && !lept_index_pays(x))
+            return 0;
+    }
+    if (len > sample) {
+        /* buffers left over from an earlier parse are reused when large enough */
+        lept_index_reserve(p, x->allocator, len, x->size);
+        memcpy(p->index, x->e, x->size * sizeof(unsigned));
+        memcpy(p->dirty, x->dirty, sample / 64 * sizeof(uint64_t));
+        x->e = p->index;
+        x->capacity = p->index_capacity;
+        x->dirty = p->dirty;
+        x->dirty[len / 64] = 0;
+        build(x, json, sample, len);
+        p->index = x->e;    /* grown when the input is dense */
+        p->index_capacity = x->capacity;
+    }
+    x->e[x->size] = (unsigned)len;
+    return 1;
+#else
+    (void)p;
+    (void)x;
+    (void)json;
+    (void)len;
+    return 0;
+#endif
+}
+
+int lept_parse_indexed(lept_value* v, const char* json) {
+    lept_parser p;
+    int ret;
+    lept_parser_init(&p);
+    ret = lept_parser_parse_indexed(&p, v, json);
+    lept_parser_free(&p);
+    return ret;
+}
+
+void lept_parser_init(lept_parser* p) {
+    assert(p != NULL);
+    p->allocator = NULL;
+    p->retain = LEPT_PARSER_RETAIN;
+    p->max_depth = LEPT_PARSER_MAX_DEPTH;
+    p->index_min = LEPT_PARSER_INDEX_MIN;
+    p->intern = NULL;
+    p->intern_id = 0;
+    p->stack = NULL;
+    p->size = 0;
+    p->index = NULL;
+    p->index_capacity = 0;
+    p->dirty = NULL;
+    p->dirty_capacity = 0;
+}
+
+static const lept_allocator* lept_parser_allocator(const lept_parser* p) {
+    return p->allocator != NULL ? p->allocator : &lept_allocator_default;
+}
+
+/* Lends the parser's stack to a new context. */
+static void lept_parser_begin(lept_parser* p, lept_context* c, const char* json, size_t len) {
+    c->json = c->base = json;
+    c->end = json + len;
+    c->stack = p->stack;
+    c->size = p->size;
+    c->top = 0;
+    c->index = NULL;
+    c->dirty = NULL;
+    c->doc = NULL;
+    c->insitu = 0;
+    c->handler = NULL;
+    c->parser = p;
+    c->frame = LEPT_FRAME_NONE;
+    c->depth = 0;
+    c->max_depth = p->max_depth;
+    c->allocator = lept_parser_allocator(p);
+}
+
+/* Takes the stack back, then drops whatever grew beyond p->retain. */
+static void lept_parser_end(lept_parser* p, lept_context* c) {
+    const lept_allocator* a = c->allocator;
+    p->stack = c->stack;
+    p->size = c->size;
+    if (p->size > p->retain) {
+        LEPT_FREE(a, p->stack, p->size);
+        p->stack = NULL;
+        p->size = 0;
+    }
+    if (p->index_capacity * sizeof(unsigned) > p->retain) {
+        LEPT_FREE(a, p->index, p->index_capacity * sizeof(unsigned));
+        p->index = NULL;
+        p->index_capacity = 0;
+    }
+    if (p->dirty_capacity * sizeof(uint64_t) > p->retain) {
+        LEPT_FREE(a, p->dirty, p->dirty_capacity * sizeof(uint64_t));
+        p->dirty = NULL;
+        p->dirty_capacity = 0;
+    }
+}
+
+int lept_parser_parse(lept_parser* p, lept_value* v, const char* json) {
+    assert(json != NULL);
+    return lept_parser_parse_n(p, v, json, strlen(json));
+}
+
+int lept_parser_parse_n(lept_parser* p, lept_value* v, const char* json, size_t len) {
     lept_context c;
     int ret;
-    assert(v != NULL);
-    c.json = json;
-    c.stack = NULL;
-    c.size = c.top = 0;
+    assert(p != NULL && v != NULL && json != NULL);
+    lept_parser_begin(p, &c, json, len);
+    ret = lept_parse_root(&c, v);
+    lept_parser_end(p, &c);
+    return ret;
+}
+
+int lept_parser_parse_indexed(lept_parser* p, lept_value* v, const char* json) {
+    lept_context c;
+    lept_index x;
+    unsigned e[LEPT_INDEX_SAMPLE + 128];
+    uint64_t dirty[LEPT_INDEX_SAMPLE / 64 + 1];
+    size_t len;
+    int ret;
+    assert(p != NULL && v != NULL && json != NULL);
+    x.allocator = lept_parser_allocator(p);
+    x.e = e;
+    x.capacity = sizeof(e) / sizeof(e[0]);
+    x.dirty = dirty;
+    if (!lept_build_index(p, &x, json, len = strlen(json)))
+        return lept_parser_parse_n(p, v, json, len);
+    lept_parser_begin(p, &c, json, len);
+    c.index = x.e;
+    c.dirty = x.dirty;
+    ret = lept_parse_root(&c, v);
+    lept_parser_end(p, &c);
+    return ret;
+}
+
+static int lept_parser_parse_into(lept_parser* p, lept_document* d, const char* json, size_t len, int insitu) {
+    lept_context c;
+    int ret;
+    assert(p != NULL && d != NULL && json != NULL);
+    lept_document_free(d);
+    lept_parser_begin(p, &c, json, len);
+    c.doc = d;
+    c.insitu = insitu;
+    if ((ret = lept_parse_root(&c, &d->root)) != LEPT_PARSE_OK)
+        lept_document_free(d);
+    lept_parser_end(p, &c);
+    return ret;
+}
+
+int lept_parser_parse_document(lept_parser* p, lept_document* d, const char* json) {
+    assert(json != NULL);
+    return lept_parser_parse_into(p, d, json, strlen(json), 0);
+}
+
+int lept_parser_parse_document_n(lept_parser* p, lept_document* d, const char* json, size_t len) {
+    return lept_parser_parse_into(p, d, json, len, 0);
+}
+
+int lept_parser_parse_insitu(lept_parser* p, lept_document* d, char* json) {
+    assert(json != NULL);
+    return lept_parser_parse_into(p, d, json, strlen(json), 1);
+}
+
+/* A view document keeps the mapping for its strings; otherwise they are copied and it goes at once. */
+int lept_parser_parse_file(lept_parser* p, lept_document* d, const char* path) {
+    void* map;
+    size_t size;
+    int ret;
+    assert(p != NULL && d != NULL && path != NULL);
+    lept_document_free(d);
+    if (!lept_map_file(path, lept_document_allocator(d), &map, &size))
+        return LEPT_PARSE_IO_ERROR;
+    ret = lept_parser_parse_into(p, d, map != NULL ? (const char*)map : "", size, 0);
+    if (ret == LEPT_PARSE_OK && d->views) {
+        d->file = map;
+        d->file_size = size;
+    }
+    else
+        lept_unmap_file(lept_document_allocator(d), map, size);
+    return ret;
+}
+
+void lept_parser_free(lept_parser* p) {
+    const lept_allocator* a;
+    assert(p != NULL);
+    a = lept_parser_allocator(p);
+    LEPT_FREE(a, p->stack, p->size);
+    LEPT_FREE(a, p->index, p->index_capacity * sizeof(unsigned));
+    LEPT_FREE(a, p->dirty, p->dirty_capacity * sizeof(uint64_t));
+    lept_parser_init(p);
+}
+
+/*
+ * Push parser. The state says what the next byte may be. Arrays and objects
+ * under construction sit on the stack behind frames, as lept_parse_value()
+ * keeps them, and the string or number being read is collected on top. An escape is buffered until it is complete. The errors
+ * are the ones lept_parse() reports for the whole input.
+ */
+
+enum {
+    LEPT_STREAM_VALUE,          /* a value */
+    LEPT_STREAM_ARRAY_FIRST,    /* a value or ']' */
+    LEPT_STREAM_OBJECT_FIRST,   /* a key or '}' */
+    LEPT_STREAM_KEY,
+    LEPT_STREAM_COLON,
+    LEPT_STREAM_NEXT,           /* ',' or the closing bracket, only whitespace at the root */
+    LEPT_STREAM_STRING,
+    LEPT_STREAM_ESCAPE,
+    LEPT_STREAM_NUMBER,
+    LEPT_STREAM_LITERAL
+};
+
+void lept_stream_init(lept_stream* s, lept_value* v) {
+    assert(s != NULL && v != NULL);
+    s->v = v;
+    s->stack = NULL;
+    s->size = s->top = 0;
+    s->frame = LEPT_FRAME_NONE;
+    s->depth = 0;
+    s->max_depth = LEPT_PARSER_MAX_DEPTH;
+    s->state = LEPT_STREAM_VALUE;
+    s->ret = LEPT_PARSE_NEED_MORE;
     lept_init(v);
+}
+
+/* Lends the stream's stack to a context over the next chunk. */
+static void lept_stream_begin(lept_stream* s, lept_context* c, const char* json, size_t len) {
+    c->json = c->base = json;
+    c->end = json + len;
+    c->stack = s->stack;
+    c->size = s->size;
+    c->top = s->top;
+    c->index = NULL;
+    c->dirty = NULL;
+    c->doc = NULL;
+    c->insitu = 0;
+    c->handler = NULL;
+    c->parser = NULL;
+    c->frame = s->frame;
+    c->depth = s->depth;
+    c->max_depth = s->max_depth;
+    c->allocator = &lept_allocator_default;
+}
+
+static void lept_stream_end(lept_stream* s, lept_context* c) {
+    s->stack = c->stack;
+    s->size = c->size;
+    s->top = c->top;
+    s->frame = c->frame;
+    s->depth = c->depth;
+}
+
+static int lept_stream_fail(lept_stream* s, lept_context* c, int ret) {
+    lept_context_unwind(c);
+    c->top = 0;
+    if (s->ret == LEPT_PARSE_OK) {
+        lept_free(s->v);
+        lept_init(s->v);
+    }
+    return s->ret = ret;
+}
+
+/* What lept_parse() says about an unexpected byte, or the end, after a value. */
+static int lept_stream_next_error(lept_context* c) {
+    if (c->frame == LEPT_FRAME_NONE)
+        return LEPT_PARSE_ROOT_NOT_SINGULAR;
+    return LEPT_FRAME(c)->type == LEPT_ARRAY ?
+        LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+}
+
+/* Hands a complete value to the innermost container, or to the root. */
+static void lept_stream_value(lept_stream* s, lept_context* c, const lept_value* e) {
+    s->state = LEPT_STREAM_NEXT;
+    if (c->frame == LEPT_FRAME_NONE) {
+        *s->v = *e;
+        s->ret = LEPT_PARSE_OK;
+    }
+    else
+        lept_context_add(c, e);
+}
+
+static int lept_stream_open(lept_stream* s, lept_context* c, lept_type type) {
+    s->state = type == LEPT_ARRAY ? LEPT_STREAM_ARRAY_FIRST : LEPT_STREAM_OBJECT_FIRST;
+    return lept_context_open(c, type);
+}
+
+static int lept_stream_close(lept_stream* s, lept_context* c) {
+    lept_value e;
+    int ret;
+    if ((ret = lept_context_close(c, &e)) == LEPT_PARSE_OK)
+        lept_stream_value(s, c, &e);
+    return ret;
+}
+
+/* A complete string becomes a value, or the key of a new member. */
+static int lept_stream_string(lept_stream* s, lept_context* c) {
+    size_t len = c->top - s->head;
+    if (s->key) {
+        c->top = s->head;
+        lept_context_key(c, c->stack + s->head, len, NULL);
+        s->state = LEPT_STREAM_COLON;
+    }
+    else {
+        lept_value e;
+        if (len > LEPT_LENGTH_MAX)
+            return LEPT_PARSE_SIZE_EXCEEDED;
+        lept_init(&e);
+        lept_context_string(c, &e, c->stack + s->head, len, NULL);
+        c->top = s->head;
+        lept_stream_value(s, c, &e);
+    }
+    return LEPT_PARSE_OK;
+}
+
+/* Bytes an escape takes after the backslash, as far as the ones read so far tell. */
+static size_t lept_stream_escape_length(const char* e, size_t len) {
+    unsigned u;
+    if (e[0] != 'u')
+        return 1;
+    if (len < 5 || !lept_parse_hex4(e + 1, e + 5, &u) || u < 0xD800 || u > 0xDBFF)
+        return 5;
+    return 11;
+}
+
+static int lept_stream_escape(lept_stream* s, lept_context* c) {
+    char buf[4];
+    size_t n;
+    int err;
+    if (!lept_parse_escape(s->escape, s->escape + s->escape_len, buf, &n, &err))
+        return err;
+    memcpy(lept_context_push(c, n), buf, n);
+    return LEPT_PARSE_OK;
+}
+
+/* Parses the collected number; *rest is the first byte it did not take, or 0. */
+static int lept_stream_number(lept_stream* s, lept_context* c, char* rest) {
+    const char* json = c->json, *end = c->end;
+    lept_value e;
+    int ret;
+    c->json = c->stack + s->head;
+    c->end = c->stack + c->top;
+    lept_init(&e);
+    ret = lept_parse_number(c, &e);
+    *rest = PEEK(c, c->json);
+    c->json = json;
+    c->end = end;
+    c->top = s->head;
+    if (ret == LEPT_PARSE_OK)
+        lept_stream_value(s, c, &e);
+    return ret;
+}
+
+static int lept_stream_run(lept_stream* s, lept_context* c) {
+    const char* p;
+    char ch, rest;
+    int ret;
+    while (c->json < c->end) {
+        ch = *c->json;
+        switch (s->state) {
+            case LEPT_STREAM_VALUE:
+            case LEPT_STREAM_ARRAY_FIRST:
+                if (ISWS(ch))
+                    break;
+                if (ch == ']' && s->state == LEPT_STREAM_ARRAY_FIRST) {
+                    lept_stream_close(s, c);
+                    break;
+                }
+                switch (ch) {
+                    case '[':
+                    case '{':
+                        if ((ret = lept_stream_open(s, c, ch == '[' ? LEPT_ARRAY : LEPT_OBJECT)) != LEPT_PARSE_OK)
+                            return lept_stream_fail(s, c, ret);
+                        break;
+                    case 't': s->literal = "true";  s->pos = 1; s->state = LEPT_STREAM_LITERAL; break;
+                    case 'f': s->literal = "false"; s->pos = 1; s->state = LEPT_STREAM_LITERAL; break;
+                    case 'n': s->literal = "null";  s->pos = 1; s->state = LEPT_STREAM_LITERAL; break;
+                    case '"':
+                        s->head = c->top;
+                        s->key = 0;
+                        s->state = LEPT_STREAM_STRING;
+                        break;
+                    default:
+                        if (ch != '-' && !ISDIGIT(ch))
+                            return lept_stream_fail(s, c, LEPT_PARSE_INVALID_VALUE);
+                        s->head = c->top;
+                        PUTC(c, ch);
+                        s->state = LEPT_STREAM_NUMBER;
+                }
+                break;
+            case LEPT_STREAM_OBJECT_FIRST:
+            case LEPT_STREAM_KEY:
+                if (ISWS(ch))
+                    break;
+                if (ch == '}' && s->state == LEPT_STREAM_OBJECT_FIRST) {
+                    lept_stream_close(s, c);
+                    break;
+                }
+                if (ch != '"')
+                    return lept_stream_fail(s, c, LEPT_PARSE_MISS_KEY);
+                s->head = c->top;
+                s->key = 1;
+                s->state = LEPT_STREAM_STRING;
+                break;
+            case LEPT_STREAM_COLON:
+                if (ISWS(ch))
+                    break;
+                if (ch != ':')
+                    return lept_stream_fail(s, c, LEPT_PARSE_MISS_COLON);
+                s->state = LEPT_STREAM_VALUE;
+                break;
+            case LEPT_STREAM_NEXT:
+                if (ISWS(ch))
+                    break;
+                if (c->frame == LEPT_FRAME_NONE)
+                    return lept_stream_fail(s, c, LEPT_PARSE_ROOT_NOT_SINGULAR);
+                if (ch == ',')
+                    s->state = LEPT_FRAME(c)->type == LEPT_ARRAY ? LEPT_STREAM_VALUE : LEPT_STREAM_KEY;
+                else if (ch == (LEPT_FRAME(c)->type == LEPT_ARRAY ? ']' : '}')) {
+                    if ((ret = lept_stream_close(s, c)) != LEPT_PARSE_OK)
+                        return lept_stream_fail(s, c, ret);
+                }
+                else
+                    return lept_stream_fail(s, c, lept_stream_next_error(c));
+                break;
+            case LEPT_STREAM_STRING:
+                for (p = c->json; p < c->end && (unsigned char)*p >= 0x20 && *p != '"' && *p != '\\'; p++)
+                    ;
+                if (p > c->json) {
+                    PUTS(c, c->json, (size_t)(p - c->json));
+                    c->json = p;
+                    continue;
+                }
+                if (ch == '"') {
+                    if ((ret = lept_stream_string(s, c)) != LEPT_PARSE_OK)
+                        return lept_stream_fail(s, c, ret);
+                }
+                else if (ch == '\\') {
+                    s->escape_len = 0;
+                    s->state = LEPT_STREAM_ESCAPE;
+                }
+                else
+                    return lept_stream_fail(s, c, LEPT_PARSE_INVALID_STRING_CHAR);
+                break;
+            case LEPT_STREAM_ESCAPE:
+                s->escape[s->escape_len++] = ch;
+                if (s->escape_len == lept_stream_escape_length(s->escape, s->escape_len)) {
+                    if ((ret = lept_stream_escape(s, c)) != LEPT_PARSE_OK)
+                        return lept_stream_fail(s, c, ret);
+                    s->state = LEPT_STREAM_STRING;
+                }
+                break;
+            case LEPT_STREAM_NUMBER:
+                if (ISDIGIT(ch) || ch == '.' || ch == 'e' || ch == 'E' || ch == '+' || ch == '-') {
+                    PUTC(c, ch);
+                    break;
+                }
+                if ((ret = lept_stream_number(s, c, &rest)) != LEPT_PARSE_OK)
+                    return lept_stream_fail(s, c, ret);
+                if (rest != '\0')
+                    return lept_stream_fail(s, c, lept_stream_next_error(c));
+                continue; /* ch comes after the number */
+            case LEPT_STREAM_LITERAL:
+                if (ch != s->literal[s->pos++])
+                    return lept_stream_fail(s, c, LEPT_PARSE_INVALID_VALUE);
+                if (s->literal[s->pos] == '\0') {
+                    lept_value e;
+                    lept_init(&e);
+                    e.type = s->literal[0] == 't' ? LEPT_TRUE : s->literal[0] == 'f' ? LEPT_FALSE : LEPT_NULL;
+                    lept_stream_value(s, c, &e);
+                }
+                break;
+        }
+        c->json++;
+    }
+    return s->ret;
+}
+
+int lept_stream_feed(lept_stream* s, const char* chunk, size_t len) {
+    lept_context c;
+    int ret;
+    assert(s != NULL && chunk != NULL);
+    if (s->ret != LEPT_PARSE_NEED_MORE && s->ret != LEPT_PARSE_OK)
+        return s->ret;
+    lept_stream_begin(s, &c, chunk, len);
+    ret = lept_stream_run(s, &c);
+    lept_stream_end(s, &c);
+    return ret;
+}
+
+int lept_stream_finish(lept_stream* s) {
+    lept_context c;
+    int ret = LEPT_PARSE_OK;
+    char rest;
+    assert(s != NULL);
+    if (s->ret != LEPT_PARSE_NEED_MORE && s->ret != LEPT_PARSE_OK)
+        return s->ret;
+    lept_stream_begin(s, &c, "", 0);
+    switch (s->state) {
+        case LEPT_STREAM_VALUE:
+        case LEPT_STREAM_ARRAY_FIRST:
+            ret = LEPT_PARSE_EXPECT_VALUE;
+            break;
+        case LEPT_STREAM_OBJECT_FIRST:
+        case LEPT_STREAM_KEY:
+            ret = LEPT_PARSE_MISS_KEY;
+            break;
+        case LEPT_STREAM_COLON:
+            ret = LEPT_PARSE_MISS_COLON;
+            break;
+        case LEPT_STREAM_STRING:
+            ret = LEPT_PARSE_MISS_QUOTATION_MARK;
+            break;
+        case LEPT_STREAM_ESCAPE:
+            if ((ret = lept_stream_escape(s, &c)) == LEPT_PARSE_OK)
+                ret = LEPT_PARSE_MISS_QUOTATION_MARK;
+            break;
+        case LEPT_STREAM_LITERAL:
+            ret = LEPT_PARSE_INVALID_VALUE;
+            break;
+        case LEPT_STREAM_NUMBER:
+            if ((ret = lept_stream_number(s, &c, &rest)) != LEPT_PARSE_OK)
+                break;
+            if (rest != '\0') {
+                ret = lept_stream_next_error(&c);
+                break;
+            }
+            /* fall through */
+        case LEPT_STREAM_NEXT:
+            if (c.frame != LEPT_FRAME_NONE)
+                ret = lept_stream_next_error(&c);
+            break;
+    }
+    if (ret != LEPT_PARSE_OK)
+        lept_stream_fail(s, &c, ret);
+    lept_stream_end(s, &c);
+    return s->ret;
+}
+
+void lept_stream_free(lept_stream* s) {
+    lept_context c;
+    assert(s != NULL);
+    lept_stream_begin(s, &c, "", 0);
+    lept_context_unwind(&c);
+    lept_stream_end(s, &c);
+    LEPT_FREE(&lept_allocator_default, s->stack, s->size);
+    s->stack = NULL;
+    s->size = s->top = 0;
+}
+
+/* SAX parsing is lept_parse_value() with a handler: the same grammar and errors, nothing built. */
+int lept_parse_sax(const lept_handler* h, const char* json) {
+    assert(json != NULL);
+    return lept_parse_sax_n(h, json, strlen(json));
+}
+
+int lept_parse_sax_n(const lept_handler* h, const char* json, size_t len) {
+    lept_parser p;
+    int ret;
+    lept_parser_init(&p);
+    ret = lept_parser_parse_sax_n(&p, h, json, len);
+    lept_parser_free(&p);
+    return ret;
+}
+
+int lept_parser_parse_sax(lept_parser* p, const lept_handler* h, const char* json) {
+    assert(json != NULL);
+    return lept_parser_parse_sax_n(p, h, json, strlen(json));
+}
+
+int lept_parser_parse_sax_n(lept_parser* p, const lept_handler* h, const char* json, size_t len) {
+    lept_context c;
+    lept_value v;
+    int ret;
+    assert(p != NULL && h != NULL && json != NULL);
+    lept_parser_begin(p, &c, json, len);
+    c.handler = h;
     lept_parse_whitespace(&c);
-    if ((ret = lept_parse_value(&c, v)) == LEPT_PARSE_OK) {
+    if ((ret = lept_parse_value(&c, &v)) == LEPT_PARSE_OK) {
         lept_parse_whitespace(&c);
-        if (*c.json != '\0') {
-            v->type = LEPT_NULL;
+        if (c.json != c.end)
             ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    assert(c.top == 0);
+    lept_parser_end(p, &c);
+    return ret;
+}
+
+/*
+ * Numbers are written with the fewest digits that parse back to the same double
+ * (Grisu2, Florian Loitsch 2010): the value and its rounding boundaries are scaled
+ * by a cached power of ten so the digits can be generated with integer arithmetic.
+ * The layout follows "%.17g", so only the digit count differs from printf.
+ * Whole numbers below 2^53 skip all of this and are printed as integers.
+ */
+
+typedef struct {
+    uint64_t f;
+    int e;
+}lept_diyfp;
+
+/* 10^k normalized to 64 bits, for k = -348, -340, ..., 340 */
+static const uint32_t lept_cached_pow_f[][2] = {
+    { 0xfa8fd5a0u, 0x081c0288u }, { 0xbaaee17fu, 0xa23ebf76u }, { 0x8b16fb20u, 0x3055ac76u }, { 0xcf42894au, 0x5dce35eau },
+    { 0x9a6bb0aau, 0x55653b2du }, { 0xe61acf03u, 0x3d1a45dfu }, { 0xab70fe17u, 0xc79ac6cau }, { 0xff77b1fcu, 0xbebcdc4fu },
+    { 0xbe5691efu, 0x416bd60cu }, { 0x8dd01fadu, 0x907ffc3cu }, { 0xd3515c28u, 0x31559a83u }, { 0x9d71ac8fu, 0xada6c9b5u },
+    { 0xea9c2277u, 0x23ee8bcbu }, { 0xaecc4991u, 0x4078536du }, { 0x823c1279u, 0x5db6ce57u }, { 0xc2109436u, 0x4dfb5637u },
+    { 0x9096ea6fu, 0x3848984fu }, { 0xd77485cbu, 0x25823ac7u }, { 0xa086cfcdu, 0x97bf97f4u }, { 0xef340a98u, 0x172aace5u },
+    { 0xb23867fbu, 0x2a35b28eu }, { 0x84c8d4dfu, 0xd2c63f3bu }, { 0xc5dd4427u, 0x1ad3cdbau }, { 0x936b9fceu, 0xbb25c996u },
+    { 0xdbac6c24u, 0x7d62a584u }, { 0xa3ab6658u, 0x0d5fdaf6u }, { 0xf3e2f893u, 0xdec3f126u }, { 0xb5b5ada8u, 0xaaff80b8u },
+    { 0x87625f05u, 0x6c7c4a8bu }, { 0xc9bcff60u, 0x34c13053u }, { 0x964e858cu, 0x91ba2655u }, { 0xdff97724u, 0x70297ebdu },
+    { 0xa6dfbd9fu, 0xb8e5b88fu }, { 0xf8a95fcfu, 0x88747d94u }, { 0xb9447093u, 0x8fa89bcfu }, { 0x8a08f0f8u, 0xbf0f156bu },
+    { 0xcdb02555u, 0x653131b6u }, { 0x993fe2c6u, 0xd07b7facu }, { 0xe45c10c4u, 0x2a2b3b06u }, { 0xaa242499u, 0x697392d3u },
+    { 0xfd87b5f2u, 0x8300ca0eu }, { 0xbce50864u, 0x92111aebu }, { 0x8cbccc09u, 0x6f5088ccu }, { 0xd1b71758u, 0xe219652cu },
+    { 0x9c400000u, 0x00000000u }, { 0xe8d4a510u, 0x00000000u }, { 0xad78ebc5u, 0xac620000u }, { 0x813f3978u, 0xf8940984u },
+    { 0xc097ce7bu, 0xc90715b3u }, { 0x8f7e32ceu, 0x7bea5c70u }, { 0xd5d238a4u, 0xabe98068u }, { 0x9f4f2726u, 0x179a2245u },
+    { 0xed63a231u, 0xd4c4fb27u }, { 0xb0de6538u, 0x8cc8ada8u }, { 0x83c7088eu, 0x1aab65dbu }, { 0xc45d1df9u, 0x42711d9au },
+    { 0x924d692cu, 0xa61be758u }, { 0xda01ee64u, 0x1a708deau }, { 0xa26da399u, 0x9aef774au }, { 0xf209787bu, 0xb47d6b85u },
+    { 0xb454e4a1u, 0x79dd1877u }, { 0x865b8692u, 0x5b9bc5c2u }, { 0xc83553c5u, 0xc8965d3du }, { 0x952ab45cu, 0xfa97a0b3u },
+    { 0xde469fbdu, 0x99a05fe3u }, { 0xa59bc234u, 0xdb398c25u }, { 0xf6c69a72u, 0xa3989f5cu }, { 0xb7dcbf53u, 0x54e9beceu },
+    { 0x88fcf317u, 0xf22241e2u }, { 0xcc20ce9bu, 0xd35c78a5u }, { 0x98165af3u, 0x7b2153dfu }, { 0xe2a0b5dcu, 0x971f303au },
+    { 0xa8d9d153u, 0x5ce3b396u }, { 0xfb9b7cd9u, 0xa4a7443cu }, { 0xbb764c4cu, 0xa7a44410u }, { 0x8bab8eefu, 0xb6409c1au },
+    { 0xd01fef10u, 0xa657842cu }, { 0x9b10a4e5u, 0xe9913129u }, { 0xe7109bfbu, 0xa19c0c9du }, { 0xac2820d9u, 0x623bf429u },
+    { 0x80444b5eu, 0x7aa7cf85u }, { 0xbf21e440u, 0x03acdd2du }, { 0x8e679c2fu, 0x5e44ff8fu }, { 0xd433179du, 0x9c8cb841u },
+    { 0x9e19db92u, 0xb4e31ba9u }, { 0xeb96bf6eu, 0xbadf77d9u }, { 0xaf87023bu, 0x9bf0ee6bu }
+};
+
+static const short lept_cached_pow_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066
+};
+
+static const uint64_t lept_pow10_u64[] = {
+    UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000), UINT64_C(10000), UINT64_C(100000),
+    UINT64_C(1000000), UINT64_C(10000000), UINT64_C(100000000), UINT64_C(1000000000),
+    UINT64_C(10000000000), UINT64_C(100000000000), UINT64_C(1000000000000), UINT64_C(10000000000000),
+    UINT64_C(100000000000000), UINT64_C(1000000000000000), UINT64_C(10000000000000000),
+    UINT64_C(100000000000000000), UINT64_C(1000000000000000000), UINT64_C(10000000000000000000)
+};
+
+static lept_diyfp lept_diyfp_make(uint64_t f, int e) {
+    lept_diyfp x;
+    x.f = f;
+    x.e = e;
+    return x;
+}
+
+static lept_diyfp lept_diyfp_mul(lept_diyfp a, lept_diyfp b) {
+    uint64_t lo, hi = lept_umul128(a.f, b.f, &lo);
+    return lept_diyfp_make(hi + (lo >> 63), a.e + b.e + 64);
+}
+
+static lept_diyfp lept_diyfp_normalize(lept_diyfp x) {
+    int s = lept_clz64(x.f);
+    return lept_diyfp_make(x.f << s, x.e - s);
+}
+
+/* Cached power c with c * 2^e in [2^-60, 2^-32) scaled to 64 bits; 10^-k is stored in *k. */
+static lept_diyfp lept_cached_pow(int e, int* k) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int i = (int)dk;
+    if (dk - i > 0.0)
+        i++;
+    i = (i >> 3) + 1;
+    *k = 348 - i * 8;
+    return lept_diyfp_make((uint64_t)lept_cached_pow_f[i][0] << 32 | lept_cached_pow_f[i][1], lept_cached_pow_e[i]);
+}
+
+/* Moves the last digit towards w while it stays inside the rounding interval. */
+static void lept_grisu_round(char* buf, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+        (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int lept_grisu_digits(lept_diyfp w, lept_diyfp mp, uint64_t delta, char* buf, int* k) {
+    int shift = -mp.e, kappa = 1, len = 0;
+    uint64_t one = (uint64_t)1 << shift, wp_w = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> shift), d;
+    uint64_t p2 = mp.f & (one - 1), rest;
+    while (kappa < 9 && p1 >= lept_pow10_u64[kappa])
+        kappa++;
+    while (kappa > 0) {
+        d = p1 / (uint32_t)lept_pow10_u64[kappa - 1];
+        p1 %= (uint32_t)lept_pow10_u64[kappa - 1];
+        if (d || len)
+            buf[len++] = (char)('0' + d);
+        kappa--;
+        rest = ((uint64_t)p1 << shift) + p2;
+        if (rest <= delta) {
+            *k += kappa;
+            lept_grisu_round(buf, len, delta, rest, lept_pow10_u64[kappa] << shift, wp_w);
+            return len;
+        }
+    }
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        d = (uint32_t)(p2 >> shift);
+        if (d || len)
+            buf[len++] = (char)('0' + d);
+        p2 &= one - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            lept_grisu_round(buf, len, delta, p2, one, -kappa < 20 ? wp_w * lept_pow10_u64[-kappa] : 0);
+            return len;
+        }
+    }
+}
+
+/* Shortest digits of d > 0 into buf, so that d = digits * 10^k. Returns the digit count. */
+static int lept_grisu2(double d, char* buf, int* k) {
+    uint64_t bits, f;
+    int e;
+    lept_diyfp w, mp, mm, c;
+    memcpy(&bits, &d, sizeof(d));
+    f = bits & (((uint64_t)1 << 52) - 1);
+    e = (int)(bits >> 52 & 0x7FF);
+    if (e != 0) {
+        f |= (uint64_t)1 << 52;
+        e -= 1075;
+    }
+    else
+        e = -1074;
+    /* boundaries halfway to the neighbours; the lower gap is narrower at a power of two */
+    mp = lept_diyfp_normalize(lept_diyfp_make((f << 1) + 1, e - 1));
+    mm = f == (uint64_t)1 << 52 ? lept_diyfp_make((f << 2) - 1, e - 2) : lept_diyfp_make((f << 1) - 1, e - 1);
+    mm.f <<= mm.e - mp.e;
+    mm.e = mp.e;
+    c = lept_cached_pow(mp.e, k);
+    w = lept_diyfp_mul(lept_diyfp_normalize(lept_diyfp_make(f, e)), c);
+    mp = lept_diyfp_mul(mp, c);
+    mm = lept_diyfp_mul(mm, c);
+    mp.f--;
+    mm.f++;
+    return lept_grisu_digits(w, mp, mp.f - mm.f, buf, k);
+}
+
+static char* lept_write_uint64(char* p, uint64_t u) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    while (n > 0)
+        *p++ = tmp[--n];
+    return p;
+}
+
+/* Writes d into p (at least 32 bytes) and returns the end. */
+static char* lept_dtoa(double d, char* p) {
+    char digits[18];
+    int len, k, x, i;
+    if (d != d || d - d != d - d)
+        return p + sprintf(p, "%.17g", d);
+    if (d < 0.0 || (d == 0.0 && 1.0 / d < 0.0)) {
+        *p++ = '-';
+        d = -d;
+    }
+    if (d < 9007199254740992.0 && d == (double)(uint64_t)d)
+        return lept_write_uint64(p, (uint64_t)d);
+    len = lept_grisu2(d, digits, &k);
+    x = len + k - 1; /* decimal exponent of the first digit */
+    /* whole doubles from 2^53 up take the exponent form, or they would read back as integers */
+    if (x >= -4 && x < len - 1) {
+        if (x < 0) {
+            *p++ = '0';
+            *p++ = '.';
+            for (i = -1; i > x; i--)
+                *p++ = '0';
+            memcpy(p, digits, len);
+            return p + len;
         }
+        memcpy(p, digits, x + 1);
+        p += x + 1;
+        *p++ = '.';
+        memcpy(p, digits + x + 1, len - x - 1);
+        return p + len - x - 1;
     }
-    assert(c.top == 0);
-    free(c.stack);
-    return ret;
+    *p++ = digits[0];
+    if (len > 1) {
+        *p++ = '.';
+        memcpy(p, digits + 1, len - 1);
+        p += len - 1;
+    }
+    *p++ = 'e';
+    *p++ = x < 0 ? '-' : '+';
+    if (x < 0)
+        x = -x;
+    if (x >= 100)
+        *p++ = (char)('0' + x / 100);
+    *p++ = (char)('0' + x / 10 % 10);
+    *p++ = (char)('0' + x % 10);
+    return p;
 }
 
 static void lept_stringify_string(lept_context* c, const char* s, size_t len) {
@@ -371,78 +2850,325 @@ static void lept_stringify_string(lept_context* c, const char* s, size_t len) {
     c->top -= size - (p - head);
 }
 
-static void lept_stringify_value(lept_context* c, const lept_value* v) {
-    size_t i;
+/*
+ * lept_stringify(), lept_copy(), lept_free() and lept_is_equal() keep the
+ * arrays and objects still to visit on a work stack instead of recursing, so
+ * that writing, tearing down or walking a deep document costs heap, not C
+ * stack. Strings and scalars are handled in place; only nested containers are
+ * pushed.
+ */
+
+static void lept_work_init(lept_context* c) {
+    c->stack = NULL;
+    c->size = c->top = 0;
+    c->doc = NULL;
+    c->allocator = &lept_allocator_default;
+}
+
+static void lept_work_free(lept_context* c) {
+    if (c->size > 0)
+        LEPT_FREE(c->allocator, c->stack, c->size);
+}
+
+static void lept_stringify_scalar(lept_context* c, const lept_value* v) {
     switch (v->type) {
         case LEPT_NULL:   PUTS(c, "null",  4); break;
         case LEPT_FALSE:  PUTS(c, "false", 5); break;
         case LEPT_TRUE:   PUTS(c, "true",  4); break;
-        case LEPT_NUMBER: c->top -= 32 - sprintf(lept_context_push(c, 32), "%.17g", v->u.n); break;
-        case LEPT_STRING: lept_stringify_string(c, v->u.s.s, v->u.s.len); break;
-        case LEPT_ARRAY:
-            PUTC(c, '[');
-            for (i = 0; i < v->u.a.size; i++) {
-                if (i > 0)
-                    PUTC(c, ',');
-                lept_stringify_value(c, &v->u.a.e[i]);
+        case LEPT_NUMBER: {
+                char* p = lept_context_push(c, 32), *end;
+                if (LEPT_KIND(v) == LEPT_NUMBER_DOUBLE)
+                    end = lept_dtoa(v->u.n, p);
+                else if (LEPT_KIND(v) == LEPT_NUMBER_UINT64 || v->u.i64 >= 0)
+                    end = lept_write_uint64(p, v->u.u64);
+                else {
+                    *p = '-';
+                    end = lept_write_uint64(p + 1, 0 - v->u.u64);
+                }
+                c->top -= 32 - (end - p);
             }
-            PUTC(c, ']');
             break;
-        case LEPT_OBJECT:
-            PUTC(c, '{');
-            for (i = 0; i < v->u.o.size; i++) {
-                if (i > 0)
-                    PUTC(c, ',');
-                lept_stringify_string(c, v->u.o.m[i].k, v->u.o.m[i].klen);
+        case LEPT_STRING: lept_stringify_string(c, LEPT_STRING(v), v->size); break;
+        default: assert(0 && "invalid type");
+    }
+}
+
+typedef struct {
+    const lept_value* v;
+    size_t i;           /* the next element or member to write */
+}lept_stringify_item;
+
+/* Writes v into c, keeping the open arrays and objects on the work stack w rather than recursing. */
+static void lept_stringify_value(lept_context* c, lept_context* w, const lept_value* v) {
+    lept_stringify_item* item;
+    const lept_value* e = NULL;
+    size_t i;
+    if (v->type < LEPT_ARRAY) {
+        lept_stringify_scalar(c, v);
+        return;
+    }
+    PUTC(c, v->type == LEPT_ARRAY ? '[' : '{');
+    item = (lept_stringify_item*)lept_context_push(w, sizeof(lept_stringify_item));
+    item->v = v;
+    item->i = 0;
+    while (w->top > 0) {
+        item = (lept_stringify_item*)(w->stack + w->top - sizeof(lept_stringify_item));
+        v = item->v;
+        /* scalars in place, up to the next nested container */
+        for (i = item->i; i < v->size; i++) {
+            if (i > 0)
+                PUTC(c, ',');
+            if (v->type == LEPT_ARRAY)
+                e = &v->u.e[i];
+            else {
+                lept_stringify_string(c, LEPT_KEY(&v->u.m[i]), v->u.m[i].klen);
                 PUTC(c, ':');
-                lept_stringify_value(c, &v->u.o.m[i].v);
+                e = &v->u.m[i].v;
             }
-            PUTC(c, '}');
-            break;
-        default: assert(0 && "invalid type");
+            if (e->type >= LEPT_ARRAY)
+                break;
+            lept_stringify_scalar(c, e);
+        }
+        if (i == v->size) {
+            PUTC(c, v->type == LEPT_ARRAY ? ']' : '}');
+            w->top -= sizeof(lept_stringify_item);
+            continue;
+        }
+        item->i = i + 1;
+        PUTC(c, e->type == LEPT_ARRAY ? '[' : '{');
+        item = (lept_stringify_item*)lept_context_push(w, sizeof(lept_stringify_item));
+        item->v = e;
+        item->i = 0;
     }
 }
 
-char* lept_stringify(const lept_value* v, size_t* length) {
-    lept_context c;
+char* lept_stringify_with(const lept_value* v, size_t* length, const lept_allocator* a) {
+    lept_context c, w;
     assert(v != NULL);
-    c.stack = (char*)malloc(c.size = LEPT_PARSE_STRINGIFY_INIT_SIZE);
+    c.allocator = a != NULL ? a : &lept_allocator_default;
+    c.stack = (char*)LEPT_MALLOC(c.allocator, c.size = LEPT_PARSE_STRINGIFY_INIT_SIZE);
     c.top = 0;
-    lept_stringify_value(&c, v);
+    lept_work_init(&w);
+    w.allocator = c.allocator;
+    lept_stringify_value(&c, &w, v);
+    lept_work_free(&w);
     if (length)
         *length = c.top;
     PUTC(&c, '\0');
-    return c.stack;
+    /* trimmed, so that the caller can free exactly length + 1 bytes */
+    return (char*)LEPT_REALLOC(c.allocator, c.stack, c.size, c.top);
+}
+
+char* lept_stringify(const lept_value* v, size_t* length) {
+    return lept_stringify_with(v, length, NULL);
+}
+
+typedef struct {
+    lept_value* dst;
+    const lept_value* src;
+}lept_copy_item;
+
+/* Copies a scalar, or pushes a container to copy later; storage comes from lept_context_alloc(). */
+static void lept_copy_child(lept_context* c, lept_value* dst, const lept_value* src) {
+    if (src->type == LEPT_STRING) {
+        size_t len = src->size;
+        lept_string_store(dst, LEPT_STRING(src), len, len > LEPT_INLINE_MAX ? (char*)lept_context_alloc(c, len + 1) : NULL);
+    }
+    else if (src->type >= LEPT_ARRAY) {
+        lept_copy_item* item = (lept_copy_item*)lept_context_push(c, sizeof(lept_copy_item));
+        lept_init(dst);
+        item->dst = dst;
+        item->src = src;
+        return;
+    }
+    else {
+        memcpy(dst, src, sizeof(lept_value));
+        dst->flags &= ~LEPT_BORROWED;
+    }
+    if (c->doc != NULL)
+        dst->flags |= LEPT_BORROWED;
+}
+
+/* Gives dst storage of its own for the container src, pushing the nested ones to copy later. */
+static void lept_copy_container(lept_context* c, lept_value* dst, const lept_value* src) {
+    size_t i, n = src->size;
+    dst->flags = c->doc != NULL ? LEPT_BORROWED : 0;
+    dst->size = dst->capacity = n;
+    if (src->type == LEPT_ARRAY) {
+        dst->type = LEPT_ARRAY;
+        dst->u.e = n > 0 ? (lept_value*)lept_context_alloc(c, n * sizeof(lept_value)) : NULL;
+        for (i = 0; i < n; i++)
+            lept_copy_child(c, &dst->u.e[i], &src->u.e[i]);
+    }
+    else {
+        const lept_member* s = src->u.m;
+        lept_member* m;
+        dst->type = LEPT_OBJECT;
+        dst->u.m = n > 0 ? (lept_member*)lept_context_alloc(c, lept_object_bytes(n)) : NULL;
+        for (i = 0, m = dst->u.m; i < n; i++, m++, s++) {
+            if (LEPT_KEY_TAG(s) == LEPT_KEY_SHARED) {
+                m->k = s->k;
+                m->klen = s->klen;
+            }
+            else
+                lept_key_store(m, LEPT_KEY(s), s->klen,
+                    s->klen >= LEPT_KEY_INLINE - 1 ? (char*)lept_context_alloc(c, s->klen + 1) : NULL);
+            lept_copy_child(c, &m->v, &s->v);
+        }
+        lept_object_rehash(dst);
+    }
+}
+
+/* Copies src into c, which lept_work_init() has set up. */
+static void lept_copy_tree(lept_context* c, lept_value* dst, const lept_value* src) {
+    lept_copy_item item;
+    if (src->type >= LEPT_ARRAY)
+        lept_copy_container(c, dst, src);
+    else
+        lept_copy_child(c, dst, src);
+    while (c->top > 0) {
+        memcpy(&item, lept_context_pop(c, sizeof(lept_copy_item)), sizeof(lept_copy_item));
+        lept_copy_container(c, item.dst, item.src);
+    }
+}
+
+/* The arena bytes a copy of src takes, as lept_copy_container() and lept_copy_child() allocate them. */
+static size_t lept_copy_bytes(lept_context* c, const lept_value* src) {
+    size_t bytes = 0, i;
+    const lept_member* m;
+    *(const lept_value**)lept_context_push(c, sizeof(const lept_value*)) = src;
+    while (c->top > 0) {
+        const lept_value* v = *(const lept_value**)lept_context_pop(c, sizeof(const lept_value*));
+        switch (v->type) {
+            case LEPT_STRING:
+                if (v->size > LEPT_INLINE_MAX)
+                    bytes += LEPT_ALIGN(v->size + 1);
+                break;
+            case LEPT_ARRAY:
+                if (v->size > 0)
+                    bytes += LEPT_ALIGN(v->size * sizeof(lept_value));
+                for (i = 0; i < v->size; i++)
+                    if (v->u.e[i].type >= LEPT_STRING)
+                        *(const lept_value**)lept_context_push(c, sizeof(const lept_value*)) = &v->u.e[i];
+                break;
+            case LEPT_OBJECT:
+                if (v->size > 0)
+                    bytes += LEPT_ALIGN(lept_object_bytes(v->size));
+                for (i = 0, m = v->u.m; i < v->size; i++, m++) {
+                    if (LEPT_KEY_TAG(m) != LEPT_KEY_SHARED && m->klen >= LEPT_KEY_INLINE - 1)
+                        bytes += LEPT_ALIGN(m->klen + 1);
+                    if (m->v.type >= LEPT_STRING)
+                        *(const lept_value**)lept_context_push(c, sizeof(const lept_value*)) = &m->v;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return bytes;
 }
 
 void lept_copy(lept_value* dst, const lept_value* src) {
+    lept_context c;
     assert(src != NULL && dst != NULL && src != dst);
-    switch (src->type) {
-        case LEPT_STRING:
-            lept_set_string(dst, src->u.s.s, src->u.s.len);
-            break;
-        case LEPT_ARRAY:
-            /* \todo */
-            break;
-        case LEPT_OBJECT:
-            /* \todo */
-            break;
-        default:
-            lept_free(dst);
-            memcpy(dst, src, sizeof(lept_value));
-            break;
+    lept_free(dst);
+    lept_work_init(&c);
+    lept_copy_tree(&c, dst, src);
+    lept_work_free(&c);
+}
+
+void lept_document_copy(lept_document* d, const lept_value* src) {
+    lept_context c;
+    size_t bytes;
+    assert(d != NULL && src != NULL);
+    lept_document_free(d);
+    lept_work_init(&c);
+    if ((bytes = lept_copy_bytes(&c, src)) > 0)
+        lept_document_reserve(d, bytes);
+    c.doc = d;
+    lept_copy_tree(&c, &d->root, src);
+    assert(d->chunks == NULL || d->chunks->used == d->chunks->size);
+    lept_work_free(&c);
+}
+
+/* Moves the storage of v behind a reference count of 1. */
+static void lept_share_payload(lept_value* v, char* p) {
+    size_t bytes = lept_payload_bytes(v);
+    char* block = (char*)LEPT_REALLOC(&lept_allocator_default, p, bytes, LEPT_REF_SIZE + bytes);
+    memmove(block + LEPT_REF_SIZE, block, bytes);
+    *(lept_refcount*)block = 1;
+    lept_set_payload(v, block + LEPT_REF_SIZE);
+    v->flags |= LEPT_SHARED;
+}
+
+/* Makes the storage of v and of everything in it shared; below shared storage, everything already is. */
+static void lept_make_shared(lept_value* v) {
+    lept_context c;
+    size_t i;
+    char* p;
+    lept_work_init(&c);
+    *(lept_value**)lept_context_push(&c, sizeof(lept_value*)) = v;
+    while (c.top > 0) {
+        v = *(lept_value**)lept_context_pop(&c, sizeof(lept_value*));
+        if (v->type < LEPT_STRING || (v->flags & LEPT_SHARED) || (p = lept_payload(v)) == NULL)
+            continue;
+        lept_share_payload(v, p);
+        for (i = 0; i < v->size && v->type != LEPT_STRING; i++)
+            *(lept_value**)lept_context_push(&c, sizeof(lept_value*)) = v->type == LEPT_ARRAY ? &v->u.e[i] : &v->u.m[i].v;
+    }
+    lept_work_free(&c);
+}
+
+void lept_share(lept_value* dst, lept_value* src) {
+    assert(dst != NULL && src != NULL && src != dst && LEPT_OWNED(src));
+    lept_free(dst);
+    if (!LEPT_IS_SHARED(src))
+        lept_make_shared(src);
+    if (LEPT_IS_SHARED(src))
+        LEPT_REF_INC(LEPT_REFS(lept_payload(src)));
+    memcpy(dst, src, sizeof(lept_value));
+}
+
+/* Gives the array or object v storage of its own before it changes, if it shares it. */
+static void lept_detach(lept_value* v) {
+    lept_value old;
+    size_t bytes, i;
+    char* p;
+    if (!LEPT_IS_SHARED(v))
+        return;
+    p = lept_payload(v);
+    bytes = lept_payload_bytes(v);
+    if (LEPT_REF_GET(LEPT_REFS(p)) == 1) {
+        /* the only reference: take the block back */
+        memmove(LEPT_REFS(p), p, bytes);
+        p = (char*)LEPT_REALLOC(&lept_allocator_default, LEPT_REFS(p), LEPT_REF_SIZE + bytes, bytes);
+        lept_set_payload(v, p);
+        v->flags &= ~LEPT_SHARED;
+        return;
+    }
+    /* everything in the copy gains a reference before the old block loses one */
+    memcpy(&old, v, sizeof(lept_value));
+    lept_set_payload(v, (char*)memcpy(LEPT_MALLOC(&lept_allocator_default, bytes), p, bytes));
+    v->flags &= ~LEPT_SHARED;
+    for (i = 0; i < v->size; i++) {
+        lept_value* e = v->type == LEPT_ARRAY ? &v->u.e[i] : &v->u.m[i].v;
+        if (LEPT_IS_SHARED(e))
+            LEPT_REF_INC(LEPT_REFS(lept_payload(e)));
+        if (v->type == LEPT_OBJECT && LEPT_KEY_TAG(&v->u.m[i]) == LEPT_KEY_HEAP)
+            lept_key_init(&v->u.m[i], v->u.m[i].k.p, v->u.m[i].klen);
     }
+    lept_free(&old);
 }
 
 void lept_move(lept_value* dst, lept_value* src) {
-    assert(dst != NULL && src != NULL && src != dst);
+    assert(dst != NULL && src != NULL && src != dst && LEPT_OWNED(src));
     lept_free(dst);
     memcpy(dst, src, sizeof(lept_value));
     lept_init(src);
 }
 
 void lept_swap(lept_value* lhs, lept_value* rhs) {
-    assert(lhs != NULL && rhs != NULL);
+    assert(lhs != NULL && rhs != NULL && LEPT_OWNED(lhs) && LEPT_OWNED(rhs));
     if (lhs != rhs) {
         lept_value temp;
         memcpy(&temp, lhs, sizeof(lept_value));
@@ -451,28 +3177,48 @@ void lept_swap(lept_value* lhs, lept_value* rhs) {
     }
 }
 
+static void lept_free_child(lept_context* c, const lept_value* v) {
+    if (v->type == LEPT_STRING)
+        lept_string_free(v);
+    else if (v->type >= LEPT_ARRAY)
+        memcpy(lept_context_push(c, sizeof(lept_value)), v, sizeof(lept_value));
+}
+
+/* Releases the storage of container v, pushing the nested ones to free later; shared storage waits for its last reference. */
+static void lept_free_container(lept_context* c, const lept_value* v) {
+    size_t i, shared = v->flags & LEPT_SHARED ? LEPT_REF_SIZE : 0;
+    if (shared && LEPT_REF_DEC(LEPT_REFS(lept_payload(v))) != 0)
+        return;
+    if (v->type == LEPT_ARRAY) {
+        for (i = 0; i < v->size; i++)
+            lept_free_child(c, &v->u.e[i]);
+        LEPT_FREE(&lept_allocator_default, (char*)v->u.e - shared, shared + v->capacity * sizeof(lept_value));
+    }
+    else {
+        for (i = 0; i < v->size; i++) {
+            lept_key_free(&v->u.m[i]);
+            lept_free_child(c, &v->u.m[i].v);
+        }
+        LEPT_FREE(&lept_allocator_default, (char*)v->u.m - shared, shared + lept_object_bytes(v->capacity));
+    }
+}
+
 void lept_free(lept_value* v) {
-    size_t i;
-    assert(v != NULL);
-    switch (v->type) {
-        case LEPT_STRING:
-            free(v->u.s.s);
-            break;
-        case LEPT_ARRAY:
-            for (i = 0; i < v->u.a.size; i++)
-                lept_free(&v->u.a.e[i]);
-            free(v->u.a.e);
-            break;
-        case LEPT_OBJECT:
-            for (i = 0; i < v->u.o.size; i++) {
-                free(v->u.o.m[i].k);
-                lept_free(&v->u.o.m[i].v);
-            }
-            free(v->u.o.m);
-            break;
-        default: break;
+    lept_context c;
+    lept_value e;
+    assert(v != NULL && LEPT_OWNED(v));
+    if (v->type == LEPT_STRING)
+        lept_string_free(v);
+    else if (v->type >= LEPT_ARRAY) {
+        lept_work_init(&c);
+        lept_free_container(&c, v);
+        while (c.top > 0) {
+            memcpy(&e, lept_context_pop(&c, sizeof(lept_value)), sizeof(lept_value));
+            lept_free_container(&c, &e);
+        }
+        lept_work_free(&c);
     }
-    v->type = LEPT_NULL;
+    lept_init(v);
 }
 
 lept_type lept_get_type(const lept_value* v) {
@@ -480,32 +3226,392 @@ lept_type lept_get_type(const lept_value* v) {
     return v->type;
 }
 
-int lept_is_equal(const lept_value* lhs, const lept_value* rhs) {
-    size_t i;
-    assert(lhs != NULL && rhs != NULL);
+/* Numbers compare by value across kinds, so 1 equals 1.0 but 2^53 + 1 differs from 2^53. */
+static int lept_number_is_equal(const lept_value* lhs, const lept_value* rhs) {
+    const lept_value* t;
+    double d;
+    if (LEPT_KIND(lhs) == LEPT_NUMBER_DOUBLE && LEPT_KIND(rhs) == LEPT_NUMBER_DOUBLE)
+        return lhs->u.n == rhs->u.n;
+    if (LEPT_KIND(lhs) == LEPT_KIND(rhs))
+        return lhs->u.u64 == rhs->u.u64;
+    if (LEPT_KIND(rhs) == LEPT_NUMBER_DOUBLE || (LEPT_KIND(lhs) == LEPT_NUMBER_UINT64 && LEPT_KIND(rhs) == LEPT_NUMBER_INT64)) {
+        t = lhs;
+        lhs = rhs;
+        rhs = t;
+    }
+    if (LEPT_KIND(lhs) == LEPT_NUMBER_INT64) /* rhs is LEPT_NUMBER_UINT64 */
+        return lhs->u.i64 >= 0 && lhs->u.u64 == rhs->u.u64;
+    d = lhs->u.n;
+    if (LEPT_KIND(rhs) == LEPT_NUMBER_INT64)
+        return d >= -9223372036854775808.0 && d < 9223372036854775808.0 &&
+            (int64_t)d == rhs->u.i64 && (double)(int64_t)d == d;
+    return d >= 0.0 && d < 18446744073709551616.0 && (uint64_t)d == rhs->u.u64 && (double)(uint64_t)d == d;
+}
+
+typedef struct {
+    const lept_value* lhs, *rhs;
+}lept_equal_item;
+
+static int lept_child_is_equal(lept_context* c, const lept_value* lhs, const lept_value* rhs) {
+    lept_equal_item* item;
     if (lhs->type != rhs->type)
         return 0;
     switch (lhs->type) {
         case LEPT_STRING:
-            return lhs->u.s.len == rhs->u.s.len && 
-                memcmp(lhs->u.s.s, rhs->u.s.s, lhs->u.s.len) == 0;
+            return lhs->size == rhs->size && 
+                memcmp(LEPT_STRING(lhs), LEPT_STRING(rhs), lhs->size) == 0;
         case LEPT_NUMBER:
-            return lhs->u.n == rhs->u.n;
+            return lept_number_is_equal(lhs, rhs);
         case LEPT_ARRAY:
-            if (lhs->u.a.size != rhs->u.a.size)
-                return 0;
-            for (i = 0; i < lhs->u.a.size; i++)
-                if (!lept_is_equal(&lhs->u.a.e[i], &rhs->u.a.e[i]))
-                    return 0;
-            return 1;
         case LEPT_OBJECT:
-            /* \todo */
+            item = (lept_equal_item*)lept_context_push(c, sizeof(lept_equal_item));
+            item->lhs = lhs;
+            item->rhs = rhs;
             return 1;
         default:
             return 1;
     }
 }
 
+/* Links each member of object v to the next one with the same key, in small when v is not hashed; NULL when all keys differ. */
+static size_t* lept_object_key_chains(const lept_value* v, size_t* small) {
+    size_t i, j, *next, *last;
+    const lept_member* m;
+    uint64_t filter = 0;
+    int dups = 0;
+    if (LEPT_OBJECT_HASHED(v)) {
+        if (!(v->flags & LEPT_DUPLICATES))
+            return NULL;
+        next = (size_t*)LEPT_MALLOC(&lept_allocator_default, 2 * v->size * sizeof(size_t));
+        last = next + v->size;  /* the last member seen so far with the key of each first one */
+        for (i = 0, m = v->u.m; i < v->size; i++, m++) {
+            next[i] = LEPT_KEY_NOT_EXIST;
+            if ((j = lept_find_object_index(v, LEPT_KEY(m), m->klen)) != i)
+                next[last[j]] = i;
+            last[j] = i;
+        }
+        return next;
+    }
+    for (i = 0, m = v->u.m; i < v->size && !dups; i++, m++) {
+        /* a cheap filter first, on length and end bytes, so that distinct keys mostly skip the pairwise pass */
+        j = (m->klen * 7 + (m->klen > 0 ? (unsigned char)LEPT_KEY(m)[0] * 3 + (unsigned char)LEPT_KEY(m)[m->klen - 1] : 0)) % 64;
+        dups = (int)(filter >> j & 1);
+        filter |= (uint64_t)1 << j;
+    }
+    if (!dups)
+        return NULL;
+    for (i = 0, m = v->u.m, dups = 0; i < v->size; i++, m++)
+        for (small[i] = LEPT_KEY_NOT_EXIST, j = i + 1; j < v->size; j++)
+            if (v->u.m[j].klen == m->klen && memcmp(LEPT_KEY(&v->u.m[j]), LEPT_KEY(m), m->klen) == 0) {
+                small[i] = j;
+                dups = 1;
+                break;
+            }
+    return dups ? small : NULL;
+}
+
+/*
+ * A member of lhs whose key rhs repeats takes the first free member of rhs
+ * with that key whose value is equal in full. Such a trial is a comparison of
+ * its own: the object waits in a frame on the work stack, under the pairs
+ * the trial pushes, until the trial's outcome resumes it.
+ */
+typedef struct {
+    const lept_value* lhs, *rhs;            /* two objects of one size */
+    size_t i, j;                            /* the member of lhs to match, and the member of rhs on trial */
+    size_t base;                            /* the work stack top of the comparison around the trial */
+    size_t* next;                           /* lept_object_key_chains() of rhs */
+    uint64_t* seen;                         /* members of rhs matched so far, once any are out of order */
+    size_t small[LEPT_OBJECT_HASH_MIN];
+    uint64_t one;
+}lept_equal_frame;
+
+static int lept_object_done(lept_equal_frame* f, int ret) {
+    size_t words = (f->rhs->size + 63) / 64;
+    if (f->seen != NULL && f->seen != &f->one)
+        LEPT_FREE(&lept_allocator_default, f->seen, words * sizeof(uint64_t));
+    if (f->next != NULL && f->next != f->small)
+        LEPT_FREE(&lept_allocator_default, f->next, 2 * f->rhs->size * sizeof(size_t));
+    return ret;
+}
+
+/* Tries member f->i of lhs against the members of rhs from j on with its key: 1 when one matches, 0 when none does, -1 with a trial of f->j opened. */
+static int lept_object_try(lept_context* c, lept_equal_frame* f, size_t j, size_t* base) {
+    const lept_value* v = &f->lhs->u.m[f->i].v, *e;
+    lept_equal_frame* saved;
+    lept_equal_item* item;
+    for (; j != LEPT_KEY_NOT_EXIST; j = f->next[j]) {
+        if (f->seen[j / 64] >> (j % 64) & 1)
+            continue;
+        e = &f->rhs->u.m[j].v;
+        if (v->type >= LEPT_ARRAY && v->type == e->type) {
+            f->j = j;
+            f->base = *base;
+            saved = (lept_equal_frame*)memcpy(lept_context_push(c, sizeof(lept_equal_frame)), f, sizeof(lept_equal_frame));
+            /* pointers into the frame itself do not survive the copy */
+            if (saved->next == f->small)
+                saved->next = NULL;
+            if (saved->seen == &f->one)
+                saved->seen = NULL;
+            *base = c->top;
+            item = (lept_equal_item*)lept_context_push(c, sizeof(lept_equal_item));
+            item->lhs = v;
+            item->rhs = e;
+            return -1;
+        }
+        if (lept_child_is_equal(c, v, e)) {
+            f->seen[j / 64] |= (uint64_t)1 << (j % 64);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Matches the members of lhs from f->i on, pushing the nested ones; 1 also when it stops for a trial. */
+static int lept_object_is_equal(lept_context* c, lept_equal_frame* f, size_t* base) {
+    const lept_value* lhs = f->lhs, *rhs = f->rhs;
+    size_t i, j, words;
+    int ret = 1, r;
+    for (; f->i < lhs->size && ret; f->i++) {
+        /* members match by key in any order, through the table of rhs once they are out of place */
+        const lept_member* m = &lhs->u.m[i = f->i];
+        const char* k = LEPT_KEY(&rhs->u.m[i]);
+        if (f->next == NULL && m->klen == rhs->u.m[i].klen && (LEPT_KEY(m) == k || memcmp(LEPT_KEY(m), k, m->klen) == 0))
+            j = i;
+        else {
+            if (f->seen == NULL) {
+                /* out of order: from here on, no member of rhs may match twice */
+                words = (rhs->size + 63) / 64;
+                f->seen = words == 1 ? &f->one : (uint64_t*)LEPT_MALLOC(&lept_allocator_default, words * sizeof(uint64_t));
+                memset(f->seen, 0, words * sizeof(uint64_t));
+                for (j = 0; j < i; j++)
+                    f->seen[j / 64] |= (uint64_t)1 << (j % 64);
+            }
+            j = lept_find_object_index(rhs, LEPT_KEY(m), m->klen);
+            if (j != LEPT_KEY_NOT_EXIST && f->next != NULL && f->next[j] != LEPT_KEY_NOT_EXIST) {
+                /* a key rhs repeats */
+                if ((r = lept_object_try(c, f, j, base)) < 0)
+                    return 1;
+                ret = r;
+                continue;
+            }
+        }
+        if (j == LEPT_KEY_NOT_EXIST || !lept_child_is_equal(c, &m->v, &rhs->u.m[j].v))
+            ret = 0;
+        else if (f->seen != NULL) {
+            ret = !(f->seen[j / 64] >> (j % 64) & 1);
+            f->seen[j / 64] |= (uint64_t)1 << (j % 64);
+        }
+    }
+    return lept_object_done(f, ret);
+}
+
+/* Takes up the object in frame f again with the outcome of its trial. */
+static int lept_object_resume(lept_context* c, lept_equal_frame* f, int ret, size_t* base) {
+    int r;
+    if (f->next == NULL)
+        f->next = f->small;
+    if (f->seen == NULL)
+        f->seen = &f->one;
+    if (ret) {
+        f->seen[f->j / 64] |= (uint64_t)1 << (f->j % 64);
+        r = 1;
+    }
+    else if ((r = lept_object_try(c, f, f->next[f->j], base)) < 0)
+        return 1;
+    if (!r)
+        return lept_object_done(f, 0);
+    f->i++;
+    return lept_object_is_equal(c, f, base);
+}
+
+/* Compares the sizes and direct children of two containers of one type, pushing the nested ones. */
+static int lept_container_is_equal(lept_context* c, const lept_value* lhs, const lept_value* rhs, size_t* base) {
+    lept_equal_frame f;
+    size_t i;
+    if (lhs->size == rhs->size && lept_payload(lhs) == lept_payload(rhs))
+        return 1;   /* shared storage */
+    if (lhs->size != rhs->size)
+        return 0;
+    if (lhs->type == LEPT_ARRAY) {
+        for (i = 0; i < lhs->size; i++)
+            if (!lept_child_is_equal(c, &lhs->u.e[i], &rhs->u.e[i]))
+                return 0;
+        return 1;
+    }
+    f.lhs = lhs;
+    f.rhs = rhs;
+    f.i = 0;
+    f.next = lept_object_key_chains(rhs, f.small);
+    f.seen = NULL;
+    return lept_object_is_equal(c, &f, base);
+}
+
+int lept_is_equal(const lept_value* lhs, const lept_value* rhs) {
+    lept_context c;
+    lept_equal_item item;
+    lept_equal_frame f;
+    size_t base = 0;    /* the work stack top of the innermost trial, 0 outside any */
+    int ret;
+    assert(lhs != NULL && rhs != NULL);
+    lept_work_init(&c);
+    if (lhs->type >= LEPT_ARRAY && lhs->type == rhs->type)
+        ret = lept_container_is_equal(&c, lhs, rhs, &base);
+    else
+        ret = lept_child_is_equal(&c, lhs, rhs);
+    for (;;) {
+        while (ret && c.top > base) {
+            memcpy(&item, lept_context_pop(&c, sizeof(lept_equal_item)), sizeof(lept_equal_item));
+            ret = lept_container_is_equal(&c, item.lhs, item.rhs, &base);
+        }
+        if (base == 0)
+            break;
+        /* a trial is over, and what it left to compare with it */
+        c.top = base;
+        memcpy(&f, lept_context_pop(&c, sizeof(lept_equal_frame)), sizeof(lept_equal_frame));
+        base = f.base;
+        ret = lept_object_resume(&c, &f, ret, &base);
+    }
+    lept_work_free(&c);
+    return ret;
+}
+
+/*
+ * Structural hashing. Strings go through four independent 64-bit lanes, 32
+ * bytes a round, in the manner of xxHash64. A number hashes its integer value
+ * when it has one, so that kinds lept_is_equal() holds equal agree; members
+ * add up their hashes, so that their order does not matter.
+ */
+
+#define LEPT_P1 UINT64_C(11400714785074694791)
+#define LEPT_P2 UINT64_C(14029467366897019727)
+#define LEPT_P3 UINT64_C(1609587929392839161)
+#define LEPT_P4 UINT64_C(9650029242287828579)
+#define LEPT_P5 UINT64_C(2870177450012600261)
+#define LEPT_ROTL(x, r) ((x) << (r) | (x) >> (64 - (r)))
+
+static uint64_t lept_hash_load(const char* p) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+static uint64_t lept_hash_round(uint64_t lane, uint64_t w) {
+    lane += w * LEPT_P2;
+    return LEPT_ROTL(lane, 31) * LEPT_P1;
+}
+
+static uint64_t lept_hash_final(uint64_t h) {
+    h ^= h >> 33;
+    h *= LEPT_P2;
+    h ^= h >> 29;
+    h *= LEPT_P3;
+    return h ^ h >> 32;
+}
+
+static uint64_t lept_hash_bytes(const char* s, size_t n, uint64_t seed) {
+    uint64_t h, w;
+    if (n >= 32) {
+        uint64_t l1 = seed + LEPT_P1 + LEPT_P2, l2 = seed + LEPT_P2, l3 = seed, l4 = seed - LEPT_P1;
+        do {
+            l1 = lept_hash_round(l1, lept_hash_load(s));
+            l2 = lept_hash_round(l2, lept_hash_load(s + 8));
+            l3 = lept_hash_round(l3, lept_hash_load(s + 16));
+            l4 = lept_hash_round(l4, lept_hash_load(s + 24));
+            s += 32;
+            n -= 32;
+        } while (n >= 32);
+        h = LEPT_ROTL(l1, 1) + LEPT_ROTL(l2, 7) + LEPT_ROTL(l3, 12) + LEPT_ROTL(l4, 18);
+    }
+    else
+        h = seed + LEPT_P5;
+    h += n;
+    for (; n >= 8; s += 8, n -= 8) {
+        h ^= lept_hash_round(0, lept_hash_load(s));
+        h = LEPT_ROTL(h, 27) * LEPT_P1 + LEPT_P4;
+    }
+    if (n > 0) {
+        w = 0;
+        memcpy(&w, s, n);
+        h ^= w * LEPT_P1;
+        h = LEPT_ROTL(h, 23) * LEPT_P2 + LEPT_P3;
+    }
+    return lept_hash_final(h);
+}
+
+static uint64_t lept_hash_number(const lept_value* v) {
+    double d = v->u.n;
+    if (LEPT_KIND(v) != LEPT_NUMBER_DOUBLE)
+        return lept_hash_final(v->u.u64 ^ LEPT_P4);
+    if (d >= -9223372036854775808.0 && d < 0.0 && (double)(int64_t)d == d)
+        return lept_hash_final((uint64_t)(int64_t)d ^ LEPT_P4);
+    if (d >= 0.0 && d < 18446744073709551616.0 && (double)(uint64_t)d == d)
+        return lept_hash_final((uint64_t)d ^ LEPT_P4);  /* -0 too */
+    return lept_hash_final(lept_hash_load((const char*)&v->u.n) ^ LEPT_P5);
+}
+
+static uint64_t lept_hash_scalar(const lept_value* v) {
+    switch (v->type) {
+        case LEPT_STRING: return lept_hash_bytes(LEPT_STRING(v), v->size, LEPT_P3);
+        case LEPT_NUMBER: return lept_hash_number(v);
+        default:          return lept_hash_final(v->type + LEPT_P1);
+    }
+}
+
+typedef struct {
+    const lept_value* v;
+    size_t next;    /* the child to hash next */
+    uint64_t h;
+}lept_hash_frame;
+
+/* Folds the hash of the last child visited into its container's. */
+static void lept_hash_add(lept_hash_frame* f, uint64_t h) {
+    const lept_member* m;
+    if (f->v->type == LEPT_ARRAY)
+        f->h = LEPT_ROTL(f->h ^ h, 29) * LEPT_P1;
+    else {
+        m = &f->v->u.m[f->next - 1];
+        f->h += lept_hash_bytes(LEPT_KEY(m), m->klen, h);
+    }
+}
+
+uint64_t lept_hash(const lept_value* v) {
+    lept_context c;
+    lept_hash_frame* f;
+    const lept_value* e;
+    uint64_t h = 0;
+    assert(v != NULL);
+    if (v->type < LEPT_ARRAY)
+        return lept_hash_scalar(v);
+    lept_work_init(&c);
+    f = (lept_hash_frame*)lept_context_push(&c, sizeof(lept_hash_frame));
+    f->v = v;
+    f->next = 0;
+    f->h = v->type == LEPT_ARRAY ? LEPT_P2 : 0;
+    while (c.top > 0) {
+        f = (lept_hash_frame*)(c.stack + c.top) - 1;
+        if (f->next < f->v->size) {
+            e = f->v->type == LEPT_ARRAY ? &f->v->u.e[f->next] : &f->v->u.m[f->next].v;
+            f->next++;
+            if (e->type < LEPT_ARRAY)
+                lept_hash_add(f, lept_hash_scalar(e));
+            else {
+                f = (lept_hash_frame*)lept_context_push(&c, sizeof(lept_hash_frame));
+                f->v = e;
+                f->next = 0;
+                f->h = e->type == LEPT_ARRAY ? LEPT_P2 : 0;
+            }
+            continue;
+        }
+        h = lept_hash_final(f->h + f->v->size + f->v->type * LEPT_P5);
+        lept_context_pop(&c, sizeof(lept_hash_frame));
+        if (c.top > 0)
+            lept_hash_add((lept_hash_frame*)(c.stack + c.top) - 1, h);
+    }
+    lept_work_free(&c);
+    return h;
+}
+
 int lept_get_boolean(const lept_value* v) {
     assert(v != NULL && (v->type == LEPT_TRUE || v->type == LEPT_FALSE));
     return v->type == LEPT_TRUE;
@@ -518,179 +3624,347 @@ void lept_set_boolean(lept_value* v, int b) {
 
 double lept_get_number(const lept_value* v) {
     assert(v != NULL && v->type == LEPT_NUMBER);
-    return v->u.n;
+    switch (LEPT_KIND(v)) {
+        case LEPT_NUMBER_INT64:  return (double)v->u.i64;
+        case LEPT_NUMBER_UINT64: return (double)v->u.u64;
+        default:                 return v->u.n;
+    }
 }
 
 void lept_set_number(lept_value* v, double n) {
     lept_free(v);
     v->u.n = n;
     v->type = LEPT_NUMBER;
+    v->flags = LEPT_NUMBER_DOUBLE;
+}
+
+lept_number_kind lept_get_number_kind(const lept_value* v) {
+    assert(v != NULL && v->type == LEPT_NUMBER);
+    return LEPT_KIND(v);
+}
+
+int64_t lept_get_int64(const lept_value* v) {
+    assert(v != NULL && v->type == LEPT_NUMBER);
+    switch (LEPT_KIND(v)) {
+        case LEPT_NUMBER_INT64:  return v->u.i64;
+        case LEPT_NUMBER_UINT64: return v->u.u64 > INT64_MAX ? INT64_MAX : (int64_t)v->u.u64;
+        default:
+            if (v->u.n != v->u.n)
+                return 0;
+            if (v->u.n >= 9223372036854775808.0)
+                return INT64_MAX;
+            if (v->u.n < -9223372036854775808.0)
+                return INT64_MIN;
+            return (int64_t)v->u.n;
+    }
+}
+
+void lept_set_int64(lept_value* v, int64_t i) {
+    lept_free(v);
+    v->u.i64 = i;
+    v->type = LEPT_NUMBER;
+    v->flags = LEPT_NUMBER_INT64;
+}
+
+uint64_t lept_get_uint64(const lept_value* v) {
+    assert(v != NULL && v->type == LEPT_NUMBER);
+    switch (LEPT_KIND(v)) {
+        case LEPT_NUMBER_INT64:  return v->u.i64 < 0 ? 0 : (uint64_t)v->u.i64;
+        case LEPT_NUMBER_UINT64: return v->u.u64;
+        default:
+            if (!(v->u.n > -1.0))   /* NaN too */
+                return 0;
+            if (v->u.n >= 18446744073709551616.0)
+                return UINT64_MAX;
+            return (uint64_t)v->u.n;
+    }
+}
+
+void lept_set_uint64(lept_value* v, uint64_t u) {
+    lept_free(v);
+    v->u.u64 = u;
+    v->type = LEPT_NUMBER;
+    v->flags = LEPT_NUMBER_UINT64;
 }
 
 const char* lept_get_string(const lept_value* v) {
     assert(v != NULL && v->type == LEPT_STRING);
-    return v->u.s.s;
+    return LEPT_STRING(v);
 }
 
 size_t lept_get_string_length(const lept_value* v) {
     assert(v != NULL && v->type == LEPT_STRING);
-    return v->u.s.len;
+    return v->size;
 }
 
 void lept_set_string(lept_value* v, const char* s, size_t len) {
-    assert(v != NULL && (s != NULL || len == 0));
+    assert(v != NULL && (s != NULL || len == 0) && len <= LEPT_LENGTH_MAX);
     lept_free(v);
-    v->u.s.s = (char*)malloc(len + 1);
-    memcpy(v->u.s.s, s, len);
-    v->u.s.s[len] = '\0';
-    v->u.s.len = len;
-    v->type = LEPT_STRING;
+    lept_string_init(v, s, len);
 }
 
 void lept_set_array(lept_value* v, size_t capacity) {
-    assert(v != NULL);
+    assert(v != NULL && capacity <= LEPT_CAPACITY_MAX);
     lept_free(v);
     v->type = LEPT_ARRAY;
-    v->u.a.size = 0;
-    v->u.a.capacity = capacity;
-    v->u.a.e = capacity > 0 ? (lept_value*)malloc(capacity * sizeof(lept_value)) : NULL;
+    v->size = 0;
+    v->capacity = capacity;
+    v->u.e = capacity > 0 ? (lept_value*)LEPT_MALLOC(&lept_allocator_default, capacity * sizeof(lept_value)) : NULL;
+}
+
+/* Doubles a full capacity, up to LEPT_CAPACITY_MAX. */
+static size_t lept_grow(size_t capacity) {
+    assert(capacity < LEPT_CAPACITY_MAX);
+    if (capacity == 0)
+        return 1;
+    return capacity < LEPT_CAPACITY_MAX / 2 ? capacity * 2 : LEPT_CAPACITY_MAX;
 }
 
 size_t lept_get_array_size(const lept_value* v) {
     assert(v != NULL && v->type == LEPT_ARRAY);
-    return v->u.a.size;
+    return v->size;
 }
 
 size_t lept_get_array_capacity(const lept_value* v) {
     assert(v != NULL && v->type == LEPT_ARRAY);
-    return v->u.a.capacity;
+    return v->capacity;
 }
 
 void lept_reserve_array(lept_value* v, size_t capacity) {
-    assert(v != NULL && v->type == LEPT_ARRAY);
-    if (v->u.a.capacity < capacity) {
-        v->u.a.capacity = capacity;
-        v->u.a.e = (lept_value*)realloc(v->u.a.e, capacity * sizeof(lept_value));
+    assert(v != NULL && v->type == LEPT_ARRAY && LEPT_OWNED(v) && capacity <= LEPT_CAPACITY_MAX);
+    lept_detach(v);
+    if (v->capacity < capacity) {
+        v->u.e = (lept_value*)LEPT_REALLOC(&lept_allocator_default, v->u.e,
+            v->capacity * sizeof(lept_value), capacity * sizeof(lept_value));
+        v->capacity = capacity;
     }
 }
 
 void lept_shrink_array(lept_value* v) {
-    assert(v != NULL && v->type == LEPT_ARRAY);
-    if (v->u.a.capacity > v->u.a.size) {
-        v->u.a.capacity = v->u.a.size;
-        v->u.a.e = (lept_value*)realloc(v->u.a.e, v->u.a.capacity * sizeof(lept_value));
+    assert(v != NULL && v->type == LEPT_ARRAY && LEPT_OWNED(v));
+    lept_detach(v);
+    if (v->capacity > v->size) {
+        v->u.e = (lept_value*)LEPT_REALLOC(&lept_allocator_default, v->u.e,
+            v->capacity * sizeof(lept_value), v->size * sizeof(lept_value));
+        v->capacity = v->size;
     }
 }
 
 void lept_clear_array(lept_value* v) {
     assert(v != NULL && v->type == LEPT_ARRAY);
-    lept_erase_array_element(v, 0, v->u.a.size);
+    lept_erase_array_element(v, 0, v->size);
 }
 
 lept_value* lept_get_array_element(lept_value* v, size_t index) {
     assert(v != NULL && v->type == LEPT_ARRAY);
-    assert(index < v->u.a.size);
-    return &v->u.a.e[index];
+    assert(index < v->size);
+    lept_detach(v);
+    return &v->u.e[index];
 }
 
 lept_value* lept_pushback_array_element(lept_value* v) {
-    assert(v != NULL && v->type == LEPT_ARRAY);
-    if (v->u.a.size == v->u.a.capacity)
-        lept_reserve_array(v, v->u.a.capacity == 0 ? 1 : v->u.a.capacity * 2);
-    lept_init(&v->u.a.e[v->u.a.size]);
-    return &v->u.a.e[v->u.a.size++];
+    assert(v != NULL && v->type == LEPT_ARRAY && LEPT_OWNED(v));
+    lept_detach(v);
+    if (v->size == v->capacity)
+        lept_reserve_array(v, lept_grow(v->capacity));
+    lept_init(&v->u.e[v->size]);
+    return &v->u.e[v->size++];
 }
 
 void lept_popback_array_element(lept_value* v) {
-    assert(v != NULL && v->type == LEPT_ARRAY && v->u.a.size > 0);
-    lept_free(&v->u.a.e[--v->u.a.size]);
+    assert(v != NULL && v->type == LEPT_ARRAY && LEPT_OWNED(v) && v->size > 0);
+    lept_detach(v);
+    lept_free(&v->u.e[--v->size]);
 }
 
 lept_value* lept_insert_array_element(lept_value* v, size_t index) {
-    assert(v != NULL && v->type == LEPT_ARRAY && index <= v->u.a.size);
-    /* \todo */
-    return NULL;
+    return lept_insert_array_elements(v, index, 1);
+}
+
+lept_value* lept_insert_array_elements(lept_value* v, size_t index, size_t count) {
+    size_t i;
+    assert(v != NULL && v->type == LEPT_ARRAY && LEPT_OWNED(v) && index <= v->size);
+    assert(count <= LEPT_CAPACITY_MAX - v->size);
+    if (count == 0)
+        return NULL;
+    lept_detach(v);
+    if (v->size + count > v->capacity) {
+        size_t capacity = lept_grow(v->capacity);
+        lept_reserve_array(v, capacity > v->size + count ? capacity : v->size + count);
+    }
+    if (index < v->size)
+        memmove(&v->u.e[index + count], &v->u.e[index], (v->size - index) * sizeof(lept_value));
+    for (i = index; i < index + count; i++)
+        lept_init(&v->u.e[i]);
+    v->size += count;
+    return &v->u.e[index];
 }
 
 void lept_erase_array_element(lept_value* v, size_t index, size_t count) {
-    assert(v != NULL && v->type == LEPT_ARRAY && index + count <= v->u.a.size);
-    /* \todo */
+    size_t i;
+    assert(v != NULL && v->type == LEPT_ARRAY && LEPT_OWNED(v) && index + count <= v->size);
+    if (count == 0)
+        return;
+    lept_detach(v);
+    for (i = index; i < index + count; i++)
+        lept_free(&v->u.e[i]);
+    memmove(&v->u.e[index], &v->u.e[index + count], (v->size - index - count) * sizeof(lept_value));
+    v->size -= count;
+}
+
+void lept_splice_array(lept_value* v, size_t index, lept_value* src) {
+    lept_value* e;
+    size_t n;
+    assert(v != NULL && v->type == LEPT_ARRAY && LEPT_OWNED(v) && index <= v->size);
+    assert(src != NULL && src->type == LEPT_ARRAY && LEPT_OWNED(src) && src != v);
+    if (src->size == 0)
+        return;
+    lept_detach(src);
+    /* src may be an element of v, which the insertion moves */
+    e = src->u.e;
+    n = src->size;
+    src->size = 0;
+    memcpy(lept_insert_array_elements(v, index, n), e, n * sizeof(lept_value));
 }
 
 void lept_set_object(lept_value* v, size_t capacity) {
-    assert(v != NULL);
+    assert(v != NULL && capacity <= LEPT_CAPACITY_MAX);
     lept_free(v);
     v->type = LEPT_OBJECT;
-    v->u.o.size = 0;
-    v->u.o.capacity = capacity;
-    v->u.o.m = capacity > 0 ? (lept_member*)malloc(capacity * sizeof(lept_member)) : NULL;
+    v->size = 0;
+    v->capacity = 0;
+    v->u.m = NULL;
+    lept_object_realloc(v, capacity);
 }
 
 size_t lept_get_object_size(const lept_value* v) {
     assert(v != NULL && v->type == LEPT_OBJECT);
-    return v->u.o.size;
+    return v->size;
 }
 
 size_t lept_get_object_capacity(const lept_value* v) {
     assert(v != NULL && v->type == LEPT_OBJECT);
-    /* \todo */
-    return 0;
+    return v->capacity;
 }
 
 void lept_reserve_object(lept_value* v, size_t capacity) {
-    assert(v != NULL && v->type == LEPT_OBJECT);
-    /* \todo */
+    assert(v != NULL && v->type == LEPT_OBJECT && LEPT_OWNED(v) && capacity <= LEPT_CAPACITY_MAX);
+    lept_detach(v);
+    if (v->capacity < capacity)
+        lept_object_realloc(v, capacity);
 }
 
 void lept_shrink_object(lept_value* v) {
-    assert(v != NULL && v->type == LEPT_OBJECT);
-    /* \todo */
+    assert(v != NULL && v->type == LEPT_OBJECT && LEPT_OWNED(v));
+    lept_detach(v);
+    if (v->capacity > v->size)
+        lept_object_realloc(v, v->size);
 }
 
 void lept_clear_object(lept_value* v) {
-    assert(v != NULL && v->type == LEPT_OBJECT);
-    /* \todo */
+    size_t i;
+    assert(v != NULL && v->type == LEPT_OBJECT && LEPT_OWNED(v));
+    lept_detach(v);
+    for (i = 0; i < v->size; i++) {
+        lept_key_free(&v->u.m[i]);
+        lept_free(&v->u.m[i].v);
+    }
+    v->size = 0;
+    lept_object_rehash(v);
 }
 
 const char* lept_get_object_key(const lept_value* v, size_t index) {
     assert(v != NULL && v->type == LEPT_OBJECT);
-    assert(index < v->u.o.size);
-    return v->u.o.m[index].k;
+    assert(index < v->size);
+    return LEPT_KEY(&v->u.m[index]);
 }
 
 size_t lept_get_object_key_length(const lept_value* v, size_t index) {
     assert(v != NULL && v->type == LEPT_OBJECT);
-    assert(index < v->u.o.size);
-    return v->u.o.m[index].klen;
+    assert(index < v->size);
+    return v->u.m[index].klen;
 }
 
 lept_value* lept_get_object_value(lept_value* v, size_t index) {
     assert(v != NULL && v->type == LEPT_OBJECT);
-    assert(index < v->u.o.size);
-    return &v->u.o.m[index].v;
+    assert(index < v->size);
+    lept_detach(v);
+    return &v->u.m[index].v;
 }
 
 size_t lept_find_object_index(const lept_value* v, const char* key, size_t klen) {
     size_t i;
     assert(v != NULL && v->type == LEPT_OBJECT && key != NULL);
-    for (i = 0; i < v->u.o.size; i++)
-        if (v->u.o.m[i].klen == klen && memcmp(v->u.o.m[i].k, key, klen) == 0)
+    if (LEPT_OBJECT_HASHED(v))
+        return *lept_object_slot(v, key, klen) - 1; /* an empty slot gives LEPT_KEY_NOT_EXIST */
+    for (i = 0; i < v->size; i++)
+        if (v->u.m[i].klen == klen && (LEPT_KEY(&v->u.m[i]) == key || memcmp(LEPT_KEY(&v->u.m[i]), key, klen) == 0))
             return i;
     return LEPT_KEY_NOT_EXIST;
 }
 
 lept_value* lept_find_object_value(lept_value* v, const char* key, size_t klen) {
     size_t index = lept_find_object_index(v, key, klen);
-    return index != LEPT_KEY_NOT_EXIST ? &v->u.o.m[index].v : NULL;
+    if (index == LEPT_KEY_NOT_EXIST)
+        return NULL;
+    lept_detach(v);
+    return &v->u.m[index].v;
 }
 
 lept_value* lept_set_object_value(lept_value* v, const char* key, size_t klen) {
-    assert(v != NULL && v->type == LEPT_OBJECT && key != NULL);
-    /* \todo */
-    return NULL;
+    size_t index;
+    lept_member* m;
+    assert(v != NULL && v->type == LEPT_OBJECT && LEPT_OWNED(v) && key != NULL);
+    lept_detach(v);
+    if ((index = lept_find_object_index(v, key, klen)) != LEPT_KEY_NOT_EXIST)
+        return &v->u.m[index].v;
+    if (v->size == v->capacity)
+        lept_reserve_object(v, lept_grow(v->capacity));
+    m = &v->u.m[v->size++];
+    lept_key_init(m, key, klen);
+    lept_init(&m->v);
+    if (LEPT_OBJECT_HASHED(v))
+        *lept_object_slot(v, key, klen) = v->size;
+    return &m->v;
+}
+
+/* Drops member index from the table ahead of its removal, unless a duplicate key takes a rehash instead. */
+static int lept_object_unindex(lept_value* v, size_t index) {
+    if (!LEPT_OBJECT_HASHED(v) || (v->flags & LEPT_DUPLICATES))
+        return 0;
+    lept_object_unslot(v, lept_object_slot_of(v, index));
+    return 1;
 }
 
 void lept_remove_object_value(lept_value* v, size_t index) {
-    assert(v != NULL && v->type == LEPT_OBJECT && index < v->u.o.size);
-    /* \todo */
+    size_t i, n, *table;
+    int indexed;
+    assert(v != NULL && v->type == LEPT_OBJECT && LEPT_OWNED(v) && index < v->size);
+    lept_detach(v);
+    if ((indexed = lept_object_unindex(v, index)) != 0)
+        for (i = 0, n = lept_object_slots(v->capacity), table = LEPT_OBJECT_TABLE(v); i < n; i++)
+            table[i] -= table[i] > index + 1; /* the members after it move down one */
+    lept_key_free(&v->u.m[index]);
+    lept_free(&v->u.m[index].v);
+    memmove(&v->u.m[index], &v->u.m[index + 1], (v->size - index - 1) * sizeof(lept_member));
+    v->size--;
+    if (!indexed)
+        lept_object_rehash(v);
+}
+
+void lept_swap_remove_object_value(lept_value* v, size_t index) {
+    size_t last;
+    int indexed;
+    assert(v != NULL && v->type == LEPT_OBJECT && LEPT_OWNED(v) && index < v->size);
+    lept_detach(v);
+    last = v->size - 1;
+    if ((indexed = lept_object_unindex(v, index)) != 0 && index != last)
+        *lept_object_slot_of(v, last) = index + 1;
+    lept_key_free(&v->u.m[index]);
+    lept_free(&v->u.m[index].v);
+    if (index != last)
+        memcpy(&v->u.m[index], &v->u.m[last], sizeof(lept_member));
+    v->size--;
+    if (!indexed)
+        lept_object_rehash(v);
 }
@@ -2,26 +2,66 @@
 #define LEPTJSON_H__
 
 #include <stddef.h> /* size_t */
+#include <stdint.h> /* int64_t, uint64_t */
 
 typedef enum { LEPT_NULL, LEPT_FALSE, LEPT_TRUE, LEPT_NUMBER, LEPT_STRING, LEPT_ARRAY, LEPT_OBJECT } lept_type;
 
+typedef enum { LEPT_NUMBER_DOUBLE, LEPT_NUMBER_INT64, LEPT_NUMBER_UINT64 } lept_number_kind;
+
 #define LEPT_KEY_NOT_EXIST ((size_t)-1)
 
 typedef struct lept_value lept_value;
 typedef struct lept_member lept_member;
 
+/*
+ * Define LEPT_COMPACT_VALUE to pack a value into 16 bytes instead of 32: string
+ * lengths are then limited to LEPT_LENGTH_MAX and array and object capacities
+ * to LEPT_CAPACITY_MAX. Larger input fails with LEPT_PARSE_SIZE_EXCEEDED.
+ */
+#ifdef LEPT_COMPACT_VALUE
+#define LEPT_LENGTH_MAX   ((size_t)0x7FFFFFFF)
+#define LEPT_CAPACITY_MAX (((size_t)1 << 26) - 1)
+#else
+#define LEPT_LENGTH_MAX   ((size_t)-1)
+#define LEPT_CAPACITY_MAX ((size_t)-1)
+#endif
+
+#define LEPT_KEY_INLINE   16  /* past any pointer, so that the last byte is free */
+
+/*
+ * Short strings and keys are copied inline instead of onto the heap: a string
+ * of up to 15 bytes (7 in the compact layout) over u and capacity, a key of up
+ * to LEPT_KEY_INLINE - 2 bytes into k.s, whose last byte is then set. Strings
+ * a view document leaves in its input stay there. lept_get_string() and
+ * lept_get_object_key() point into the value or member for inline ones.
+ */
+
 struct lept_value {
     union {
-        struct { lept_member* m; size_t size, capacity; }o; /* object: members, member count, capacity */
-        struct { lept_value*  e; size_t size, capacity; }a; /* array:  elements, element count, capacity */
-        struct { char* s; size_t len; }s;                   /* string: null-terminated string, string length */
-        double n;                                           /* number */
+        lept_member* m;     /* object: members */
+        lept_value*  e;     /* array:  elements */
+        char* s;            /* string: a longer one, null-terminated (except views) */
+        double n;           /* number: LEPT_NUMBER_DOUBLE */
+        int64_t i64;        /* number: LEPT_NUMBER_INT64 */
+        uint64_t u64;       /* number: LEPT_NUMBER_UINT64 */
     }u;
+#ifdef LEPT_COMPACT_VALUE
+    uint32_t size;
+    unsigned type : 3, flags : 3, capacity : 26;
+#else
+    size_t capacity;        /* array and object capacity */
+    size_t size;            /* element count, member count or string length */
     lept_type type;
+    unsigned flags;         /* number: lept_number_kind, and internal bits */
+#endif
 };
 
 struct lept_member {
-    char* k; size_t klen;   /* member key string, key string length */
+    union {
+        char* p;                    /* a longer key, null-terminated (except views) */
+        char s[LEPT_KEY_INLINE];    /* a short key, null-terminated, and a nonzero last byte */
+    }k;
+    size_t klen;            /* key string length */
     lept_value v;           /* member value */
 };
 
@@ -39,15 +79,208 @@ enum {
     LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET,
     LEPT_PARSE_MISS_KEY,
     LEPT_PARSE_MISS_COLON,
-    LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET
+    LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET,
+    LEPT_PARSE_IO_ERROR,
+    LEPT_PARSE_NEED_MORE,
+    LEPT_PARSE_ABORTED,
+    LEPT_PARSE_DEPTH_EXCEEDED,
+    LEPT_PARSE_SIZE_EXCEEDED
 };
 
-#define lept_init(v) do { (v)->type = LEPT_NULL; } while(0)
+/*
+ * Memory hooks. realloc_fn and free_fn get the size the block was allocated
+ * with, and accept NULL with size 0 like their C counterparts.
+ */
+typedef struct {
+    void* (*malloc_fn)(void* user, size_t size);
+    void* (*realloc_fn)(void* user, void* ptr, size_t old_size, size_t size);
+    void (*free_fn)(void* user, void* ptr, size_t size);
+    void* user;
+}lept_allocator;
+
+/* Process-wide allocator for values; NULL restores malloc(). Change it only while nothing allocated is alive. */
+void lept_set_allocator(const lept_allocator* a);
+const lept_allocator* lept_get_allocator(void);
+
+#define lept_init(v) do { (v)->type = LEPT_NULL; (v)->flags = 0; } while(0)
 
 int lept_parse(lept_value* v, const char* json);
+/* The _n variants read exactly len bytes, which need not be null-terminated; a NUL byte among them is invalid JSON. */
+int lept_parse_n(lept_value* v, const char* json, size_t len);
+/* Takes the structural index when it speeds up json, as lept_parser_parse_indexed() decides, and lept_parse() otherwise. */
+int lept_parse_indexed(lept_value* v, const char* json);
+
+typedef struct lept_chunk lept_chunk;
+
+/*
+ * A parsed document whose strings, keys, elements and members all live in one
+ * arena, freed chunk by chunk. Its values are read-only: lept_copy one out to
+ * change it.
+ *
+ * With views set, strings and keys without escapes are not copied but point
+ * into the input, which then has to outlive the document. Such strings are
+ * not null-terminated: use their length.
+ *
+ * lept_document_parse_insitu() goes further and decodes every string over its
+ * own source, null-terminating it there. The input is destroyed, even on
+ * error, and has to outlive the document.
+ *
+ * lept_document_parse_file() parses straight from a read-only mapping of the
+ * file, which a view document keeps until it is freed.
+ */
+typedef struct {
+    lept_value root;
+    lept_chunk* chunks;
+    const lept_allocator* allocator;    /* for chunks and the parse stack, NULL for the process-wide one */
+    int views;                          /* keep escape-free strings in the input buffer */
+    void* file;                         /* mapping the views point into, if parsed from a file */
+    size_t file_size;
+}lept_document;
+
+#define lept_document_init(d) do {\
+        lept_init(&(d)->root);\
+        (d)->chunks = NULL;\
+        (d)->allocator = NULL;\
+        (d)->views = 0;\
+        (d)->file = NULL;\
+        (d)->file_size = 0;\
+    } while(0)
+
+int lept_document_parse(lept_document* d, const char* json);
+int lept_document_parse_n(lept_document* d, const char* json, size_t len);
+int lept_document_parse_insitu(lept_document* d, char* json);
+int lept_document_parse_file(lept_document* d, const char* path);
+void lept_document_free(lept_document* d);
+/* Copies src, which must not belong to d, into d as a single block sized to fit. */
+void lept_document_copy(lept_document* d, const lept_value* src);
+
+/*
+ * A pool of object keys shared between parses, and between threads. A parser
+ * with intern set points every key too long to be stored inline into the
+ * pool rather than copying it, and lept_copy() shares such keys as well, so
+ * the pool has to outlive every value holding one. lept_intern_key() returns
+ * the pooled, null-terminated copy of a key; lept_find_object_index() and
+ * lept_is_equal() match pooled keys by pointer before comparing bytes.
+ */
+typedef struct lept_intern lept_intern;
+
+/* a gives the pool's memory, NULL for the process-wide allocator. */
+lept_intern* lept_intern_new(const lept_allocator* a);
+const char* lept_intern_key(lept_intern* t, const char* key, size_t klen);
+size_t lept_intern_count(lept_intern* t);
+void lept_intern_free(lept_intern* t);
+
+/*
+ * Keeps the parse stack and the structural index buffers between parses.
+ * A buffer that grew beyond retain bytes is released when the parse ends.
+ * Input nested deeper than max_depth fails with LEPT_PARSE_DEPTH_EXCEEDED;
+ * the one-shot functions use LEPT_PARSER_MAX_DEPTH. Keys taken from intern
+ * are remembered, so that meeting them again does not take the pool's lock.
+ * lept_parser_parse_indexed() parses without the index input shorter than
+ * index_min, or whose first kilobyte is mostly numbers and literals, which
+ * the index only slows down; an index_min of 0 indexes everything.
+ */
+#define LEPT_PARSER_RECENT 32
+
+typedef struct {
+    const lept_allocator* allocator;    /* for the buffers below, NULL for the process-wide one */
+    size_t retain;                      /* LEPT_PARSER_RETAIN after lept_parser_init() */
+    size_t max_depth;                   /* deepest nesting of arrays and objects, LEPT_PARSER_MAX_DEPTH */
+    size_t index_min;                   /* LEPT_PARSER_INDEX_MIN after lept_parser_init() */
+    lept_intern* intern;                /* pool for long keys, NULL to copy each one */
+    size_t intern_id;                   /* the pool the recent keys came from, 0 for none */
+    const char* recent[LEPT_PARSER_RECENT];
+    size_t recent_klen[LEPT_PARSER_RECENT];
+    char* stack;
+    size_t size;
+    unsigned* index;
+    size_t index_capacity;
+    uint64_t* dirty;
+    size_t dirty_capacity;
+}lept_parser;
+
+#define LEPT_PARSER_RETAIN (1 << 20)
+#define LEPT_PARSER_MAX_DEPTH 1024
+#define LEPT_PARSER_INDEX_MIN 64
+
+void lept_parser_init(lept_parser* p);
+int lept_parser_parse(lept_parser* p, lept_value* v, const char* json);
+int lept_parser_parse_n(lept_parser* p, lept_value* v, const char* json, size_t len);
+int lept_parser_parse_indexed(lept_parser* p, lept_value* v, const char* json);
+int lept_parser_parse_document(lept_parser* p, lept_document* d, const char* json);
+int lept_parser_parse_document_n(lept_parser* p, lept_document* d, const char* json, size_t len);
+int lept_parser_parse_insitu(lept_parser* p, lept_document* d, char* json);
+int lept_parser_parse_file(lept_parser* p, lept_document* d, const char* path);
+void lept_parser_free(lept_parser* p);
+
+/*
+ * Push parser for input that arrives in pieces. lept_stream_feed() takes a
+ * whole chunk, keeping a partial token for the next one, and returns
+ * LEPT_PARSE_NEED_MORE, LEPT_PARSE_OK once the value is complete, or an
+ * error. lept_stream_finish() marks the end of the input, where a number at
+ * the root completes. The value goes to v, which is left null on error.
+ * max_depth is set as for lept_parser.
+ */
+typedef struct {
+    lept_value* v;
+    char* stack;
+    size_t size, top;
+    size_t frame;       /* innermost open array or object on the stack */
+    size_t depth, max_depth;
+    size_t head;        /* start of the string or number being read */
+    const char* literal;
+    size_t pos;         /* next character of literal */
+    char escape[12];    /* escape being read, after the backslash */
+    size_t escape_len;
+    int state, key, ret;
+}lept_stream;
+
+void lept_stream_init(lept_stream* s, lept_value* v);
+int lept_stream_feed(lept_stream* s, const char* chunk, size_t len);
+int lept_stream_finish(lept_stream* s);
+void lept_stream_free(lept_stream* s);
+
+/*
+ * SAX parsing: each value goes to the handler as it is read and no tree is
+ * built. A callback returns nonzero to go on, or 0 to stop the parse with
+ * LEPT_PARSE_ABORTED; NULL callbacks are skipped. Strings and keys are only
+ * valid during the call and are not null-terminated. A number comes as a
+ * LEPT_NUMBER value, read with its getters. The errors are those of
+ * lept_parse(), after the events for everything before the error.
+ */
+typedef struct {
+    int (*on_null)(void* user);
+    int (*on_bool)(void* user, int b);
+    int (*on_number)(void* user, const lept_value* n);
+    int (*on_string)(void* user, const char* s, size_t len);
+    int (*on_start_object)(void* user);
+    int (*on_key)(void* user, const char* k, size_t klen);
+    int (*on_end_object)(void* user, size_t size);
+    int (*on_start_array)(void* user);
+    int (*on_end_array)(void* user, size_t size);
+    void* user;
+}lept_handler;
+
+int lept_parse_sax(const lept_handler* h, const char* json);
+int lept_parse_sax_n(const lept_handler* h, const char* json, size_t len);
+int lept_parser_parse_sax(lept_parser* p, const lept_handler* h, const char* json);
+int lept_parser_parse_sax_n(lept_parser* p, const lept_handler* h, const char* json, size_t len);
+
 char* lept_stringify(const lept_value* v, size_t* length);
+/* The result takes length + 1 bytes from a, or from the process-wide allocator when a is NULL. */
+char* lept_stringify_with(const lept_value* v, size_t* length, const lept_allocator* a);
 
 void lept_copy(lept_value* dst, const lept_value* src);
+/*
+ * Copies src into dst in constant time by sharing its strings, elements and
+ * members under atomic reference counts; the first share of a tree marks all
+ * of it, once. Shared storage is copied on write: whatever can change an
+ * array or object, lept_get_array_element() and lept_find_object_value()
+ * included, first gives it storage of its own, so a change copies only the
+ * path down to it. Values sharing storage may be read and freed on different
+ * threads, though each value belongs to one thread.
+ */
+void lept_share(lept_value* dst, lept_value* src);
 void lept_move(lept_value* dst, lept_value* src);
 void lept_swap(lept_value* lhs, lept_value* rhs);
 
@@ -55,6 +288,8 @@ void lept_free(lept_value* v);
 
 lept_type lept_get_type(const lept_value* v);
 int lept_is_equal(const lept_value* lhs, const lept_value* rhs);
+/* A 64-bit hash of v, alike for values lept_is_equal() holds equal; it may differ between builds. */
+uint64_t lept_hash(const lept_value* v);
 
 #define lept_set_null(v) lept_free(v)
 
@@ -63,6 +298,16 @@ void lept_set_boolean(lept_value* v, int b);
 
 double lept_get_number(const lept_value* v);
 void lept_set_number(lept_value* v, double n);
+lept_number_kind lept_get_number_kind(const lept_value* v);
+/*
+ * lept_get_int64() and lept_get_uint64() read a number of any kind, a double
+ * truncated toward zero. Values beyond the range of the result saturate to
+ * its nearest end, and NaN reads as 0.
+ */
+int64_t lept_get_int64(const lept_value* v);
+void lept_set_int64(lept_value* v, int64_t i);
+uint64_t lept_get_uint64(const lept_value* v);
+void lept_set_uint64(lept_value* v, uint64_t u);
 
 const char* lept_get_string(const lept_value* v);
 size_t lept_get_string_length(const lept_value* v);
@@ -78,7 +323,11 @@ lept_value* lept_get_array_element(lept_value* v, size_t index);
 lept_value* lept_pushback_array_element(lept_value* v);
 void lept_popback_array_element(lept_value* v);
 lept_value* lept_insert_array_element(lept_value* v, size_t index);
+/* Opens count null elements at index, with one move of the tail, and returns the first; NULL when count is 0. */
+lept_value* lept_insert_array_elements(lept_value* v, size_t index, size_t count);
 void lept_erase_array_element(lept_value* v, size_t index, size_t count);
+/* Moves the elements of src into v at index, without copying them; src is left empty. */
+void lept_splice_array(lept_value* v, size_t index, lept_value* src);
 
 void lept_set_object(lept_value* v, size_t capacity);
 size_t lept_get_object_size(const lept_value* v);
@@ -93,5 +342,7 @@ size_t lept_find_object_index(const lept_value* v, const char* key, size_t klen)
 lept_value* lept_find_object_value(lept_value* v, const char* key, size_t klen);
 lept_value* lept_set_object_value(lept_value* v, const char* key, size_t klen);
 void lept_remove_object_value(lept_value* v, size_t index);
+/* Removes member index in constant time by moving the last member into its place. */
+void lept_swap_remove_object_value(lept_value* v, size_t index);
 
 #endif /* LEPTJSON_H__ */
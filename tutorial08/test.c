@@ -102,6 +102,52 @@ static void test_parse_number() {
     TEST_NUMBER(-2.2250738585072014e-308, "-2.2250738585072014e-308");
     TEST_NUMBER( 1.7976931348623157e+308, "1.7976931348623157e+308");  /* Max double */
     TEST_NUMBER(-1.7976931348623157e+308, "-1.7976931348623157e+308");
+
+    /* correct rounding beyond the fast paths */
+    TEST_NUMBER(0.1, "0.1");
+    TEST_NUMBER(1e-5, "0.00001");
+    TEST_NUMBER(9007199254740992.0, "9007199254740993");  /* 2^53 + 1, ties to even */
+    TEST_NUMBER(1.2345678901234568e+29, "123456789012345678901234567890");
+    TEST_NUMBER(1.0, "1.00000000000000011102230246251565404236316680908203125"); /* halfway, ties to even */
+    TEST_NUMBER(1.0000000000000002, "1.00000000000000011102230246251565404236316680908203126");
+    TEST_NUMBER(1.0000000000000002, "1.000000000000000111022302462515654042363166809082031250000000000000000000000000001");
+    TEST_NUMBER(2.2250738585072009e-308, "2.2250738585072011e-308");
+    TEST_NUMBER(0.0, "2.4703282292062327e-324"); /* below half the minimum denormal */
+    TEST_NUMBER(4.9406564584124654e-324, "2.4703282292062328e-324"); /* above half */
+}
+
+#define TEST_INTEGER(kind, expect, json)\
+    do {\
+        lept_value v;\
+        lept_init(&v);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
+        EXPECT_EQ_INT(LEPT_NUMBER, lept_get_type(&v));\
+        EXPECT_EQ_INT(kind, lept_get_number_kind(&v));\
+        if ((kind) == LEPT_NUMBER_UINT64)\
+            EXPECT_TRUE(lept_get_uint64(&v) == (uint64_t)(expect));\
+        else\
+            EXPECT_TRUE((uint64_t)lept_get_int64(&v) == (uint64_t)(expect));\
+        lept_free(&v);\
+    } while(0)
+
+static void test_parse_integer() {
+    TEST_INTEGER(LEPT_NUMBER_INT64, 0, "0");
+    TEST_INTEGER(LEPT_NUMBER_INT64, 123, "123");
+    TEST_INTEGER(LEPT_NUMBER_INT64, -123, "-123");
+    TEST_INTEGER(LEPT_NUMBER_INT64, INT64_C(9007199254740993), "9007199254740993"); /* 2^53 + 1 */
+    TEST_INTEGER(LEPT_NUMBER_INT64, INT64_MAX, "9223372036854775807");
+    TEST_INTEGER(LEPT_NUMBER_INT64, INT64_MIN, "-9223372036854775808");
+    TEST_INTEGER(LEPT_NUMBER_UINT64, UINT64_C(9223372036854775808), "9223372036854775808");
+    TEST_INTEGER(LEPT_NUMBER_UINT64, UINT64_C(10000000000000000000), "10000000000000000000");
+    TEST_INTEGER(LEPT_NUMBER_UINT64, UINT64_MAX, "18446744073709551615");
+
+    /* -0, fractions, exponents and out-of-range integers stay doubles */
+    TEST_NUMBER(0.0, "-0");
+    TEST_NUMBER(1.0, "1.0");
+    TEST_NUMBER(100.0, "1e2");
+    TEST_NUMBER(18446744073709551616.0, "18446744073709551616");
+    TEST_NUMBER(-9223372036854775809.0, "-9223372036854775809");
+    TEST_NUMBER(1e20, "100000000000000000000");
 }
 
 #define TEST_STRING(expect, json)\
@@ -345,11 +391,423 @@ static void test_parse_miss_comma_or_curly_bracket() {
     TEST_PARSE_ERROR(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{}");
 }
 
+/* Both with the index wherever it pays and with it everywhere. */
+#define TEST_PARSE_INDEXED(json)\
+    do {\
+        lept_value v1, v2, v3;\
+        lept_parser p;\
+        int ret;\
+        lept_init(&v1);\
+        lept_init(&v2);\
+        lept_init(&v3);\
+        lept_parser_init(&p);\
+        p.index_min = 0;\
+        ret = lept_parse(&v1, json);\
+        EXPECT_EQ_INT(ret, lept_parse_indexed(&v2, json));\
+        EXPECT_EQ_INT(ret, lept_parser_parse_indexed(&p, &v3, json));\
+        if (ret == LEPT_PARSE_OK) {\
+            char* json1 = lept_stringify(&v1, NULL);\
+            char* json2 = lept_stringify(&v2, NULL);\
+            char* json3 = lept_stringify(&v3, NULL);\
+            EXPECT_TRUE(strcmp(json1, json2) == 0);\
+            EXPECT_TRUE(strcmp(json1, json3) == 0);\
+            free(json1);\
+            free(json2);\
+            free(json3);\
+        }\
+        lept_free(&v1);\
+        lept_free(&v2);\
+        lept_free(&v3);\
+        lept_parser_free(&p);\
+    } while(0)
+
+/* Input past the sample: indexed in two parts when it is mostly strings, not at all when it is mostly numbers. */
+static void test_parse_indexed_sampled() {
+    char* json = (char*)malloc(5000);
+    size_t i, len;
+    for (i = 0, len = 1; len < 4900; i++)
+        len += sprintf(json + len, "%s\"s%lu\\n\",%lu", i ? "," : "", (unsigned long)i, (unsigned long)i);
+    json[0] = '[';
+    strcpy(json + len, "]");
+    TEST_PARSE_INDEXED(json);
+    strcpy(json + len, ",1 2]");
+    TEST_PARSE_INDEXED(json);
+    for (i = 0, len = 1; len < 4900; i++)
+        len += sprintf(json + len, "%s%lu.5", i ? "," : "", (unsigned long)i);
+    strcpy(json + len, ",\"a\"]");
+    TEST_PARSE_INDEXED(json);
+    free(json);
+}
+
+static void test_parse_indexed() {
+    TEST_PARSE_INDEXED("");
+    TEST_PARSE_INDEXED(" null ");
+    TEST_PARSE_INDEXED("null x");
+    TEST_PARSE_INDEXED("nullx");
+    TEST_PARSE_INDEXED("[1 2]");
+    TEST_PARSE_INDEXED("\"abc");
+    TEST_PARSE_INDEXED("\"a\\\"b\"");
+    TEST_PARSE_INDEXED("\"\\\\\"");
+    TEST_PARSE_INDEXED("\"\\\\\\\"\"");
+    TEST_PARSE_INDEXED("\"\x01\"");
+    TEST_PARSE_INDEXED("{\"a\":1,\"a\":[true , false ,null],\"b\" : {\"c\":\"\\u20AC\"}}");
+    /* strings, escapes and whitespace across 64-byte block boundaries */
+    TEST_PARSE_INDEXED("[\"0123456789012345678901234567890123456789012345678901234567890123456789\"]");
+    TEST_PARSE_INDEXED("[                                                              \"a\\\"b\" , 1]");
+    TEST_PARSE_INDEXED("[                                                             \"\\\\\\\\\\\"\", 1]");
+    TEST_PARSE_INDEXED("[                                                              \"\\\\\\\\\\\"\", 1]");
+    TEST_PARSE_INDEXED("{\"0123456789012345678901234567890123456789012345678901234567\":  \"x\\\\\"  , \"k\" : [ 12345678 ] }");
+    TEST_PARSE_INDEXED("[ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7 ]");
+    TEST_PARSE_INDEXED("[ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7 ] x");
+    test_parse_indexed_sampled();
+}
+
+/* Parses the first len bytes of json from an unterminated copy, and compares with lept_parse() of a terminated one. */
+#define TEST_PARSE_N(expect, json, len)\
+    do {\
+        lept_value v1, v2;\
+        char* exact = (char*)malloc(len + 1);\
+        char* terminated = (char*)malloc(len + 1);\
+        memcpy(exact + 1, json, len);\
+        memcpy(terminated, json, len);\
+        terminated[len] = '\0';\
+        lept_init(&v1);\
+        lept_init(&v2);\
+        EXPECT_EQ_INT(expect, lept_parse_n(&v1, exact + 1, len));\
+        if (expect == LEPT_PARSE_OK) {\
+            EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v2, terminated));\
+            EXPECT_TRUE(lept_is_equal(&v1, &v2));\
+        }\
+        lept_free(&v1);\
+        lept_free(&v2);\
+        free(exact);\
+        free(terminated);\
+    } while(0)
+
+static void test_parse_n() {
+    lept_value v;
+    TEST_PARSE_N(LEPT_PARSE_OK, "[1,\"a\"]xyz", 7);
+    TEST_PARSE_N(LEPT_PARSE_OK, "12345", 3);
+    TEST_PARSE_N(LEPT_PARSE_OK, "1.5e10", 5);
+    TEST_PARSE_N(LEPT_PARSE_OK, "truex", 4);
+    TEST_PARSE_N(LEPT_PARSE_OK, "\"ab\"c", 4);
+    TEST_PARSE_N(LEPT_PARSE_OK, "{\"a\" : [ null ] }  ", 19);
+    TEST_PARSE_N(LEPT_PARSE_OK, "0.1000000000000000055511151231257827021181583404541015625", 57);
+    TEST_PARSE_N(LEPT_PARSE_OK, "0.10000000000000000555111512312578270211815834045410156251", 57);
+    TEST_PARSE_N(LEPT_PARSE_EXPECT_VALUE, "", 0);
+    TEST_PARSE_N(LEPT_PARSE_EXPECT_VALUE, "  x", 2);
+    TEST_PARSE_N(LEPT_PARSE_EXPECT_VALUE, "[1,2]", 3);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, "true", 3);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, "-1", 1);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, "1.5", 2);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, "1e+5", 3);
+    TEST_PARSE_N(LEPT_PARSE_MISS_QUOTATION_MARK, "\"abc\"", 4);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_STRING_ESCAPE, "\"\\n\"", 2);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_UNICODE_HEX, "\"\\u0041\"", 5);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD834\\uDD1E\"", 8);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD834\\uDD1E\"", 7);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_UNICODE_HEX, "\"\\uD834\\uDD1E\"", 12);
+    TEST_PARSE_N(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1,2]", 4);
+    TEST_PARSE_N(LEPT_PARSE_MISS_KEY, "{\"a\":1,\"b\":2}", 7);
+    TEST_PARSE_N(LEPT_PARSE_MISS_COLON, "{\"a\":1}", 4);
+    TEST_PARSE_N(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1}", 6);
+
+    /* NUL bytes are data, not the end */
+    TEST_PARSE_N(LEPT_PARSE_ROOT_NOT_SINGULAR, "1\0", 2);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_VALUE, "[\0]", 3);
+    TEST_PARSE_N(LEPT_PARSE_INVALID_STRING_CHAR, "\"a\0b\"", 5);
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_n(&v, "\"a\\u0000b\"", 10));
+    EXPECT_EQ_STRING("a\0b", lept_get_string(&v), lept_get_string_length(&v));
+    lept_free(&v);
+}
+
+/* Feeds json in chunks of every size, each in a buffer of its own, and compares with lept_parse(). */
+#define TEST_STREAM(json)\
+    do {\
+        size_t len = sizeof(json) - 1, step, i, n, mismatches = 0;\
+        lept_value v1, v2;\
+        lept_stream s;\
+        int ret;\
+        lept_init(&v1);\
+        ret = lept_parse(&v1, json);\
+        for (step = 1; step <= len + 1; step++) {\
+            lept_stream_init(&s, &v2);\
+            for (i = 0; i < len; i += n) {\
+                char* chunk = (char*)malloc(step);\
+                memcpy(chunk, json + i, n = len - i < step ? len - i : step);\
+                lept_stream_feed(&s, chunk, n);\
+                free(chunk);\
+            }\
+            mismatches += lept_stream_finish(&s) != ret || (ret == LEPT_PARSE_OK && !lept_is_equal(&v1, &v2));\
+            lept_stream_free(&s);\
+            lept_free(&v2);\
+        }\
+        EXPECT_EQ_SIZE_T(0, mismatches);\
+        lept_free(&v1);\
+    } while(0)
+
+static void test_parse_stream() {
+    lept_stream s;
+    lept_value v;
+
+    TEST_STREAM("null");
+    TEST_STREAM(" true ");
+    TEST_STREAM("false");
+    TEST_STREAM("-0");
+    TEST_STREAM("123456789012345678901234567890");
+    TEST_STREAM("1.5e-10 ");
+    TEST_STREAM("\"Hello\\nWorld \\u20AC \\uD834\\uDD1E \\\" \\/\"");
+    TEST_STREAM("[ null , false , true , 123 , \"abc\", [ 1, [] , {} ] ]");
+    TEST_STREAM(" { \"n\" : null , \"a\" : [ 1, 2, 3 ], \"o\" : { \"1\" : 1, \"\\u0041\" : \"\" } } ");
+    TEST_STREAM("{\"0\":0,\"1\":1,\"2\":2,\"3\":3,\"4\":4,\"5\":5,\"6\":6,\"7\":7,\"8\":8,\"9\":9,"
+        "\"10\":10,\"11\":11,\"12\":12,\"13\":13,\"14\":14,\"15\":15,\"16\":16,\"16\":[17]}");
+
+    /* errors */
+    TEST_STREAM("");
+    TEST_STREAM(" ");
+    TEST_STREAM("nul");
+    TEST_STREAM("nulx");
+    TEST_STREAM("?");
+    TEST_STREAM("+1");
+    TEST_STREAM(".1");
+    TEST_STREAM("1.");
+    TEST_STREAM("1e");
+    TEST_STREAM("01");
+    TEST_STREAM("1-2");
+    TEST_STREAM("1e309");
+    TEST_STREAM("null x");
+    TEST_STREAM("[1,]");
+    TEST_STREAM("[1 2]");
+    TEST_STREAM("[1-2]");
+    TEST_STREAM("[\"a\"");
+    TEST_STREAM("[[1]");
+    TEST_STREAM("\"abc");
+    TEST_STREAM("\"\\v\"");
+    TEST_STREAM("\"\\");
+    TEST_STREAM("\"\x01\"");
+    TEST_STREAM("\"\\u12\"");
+    TEST_STREAM("\"\\u12");
+    TEST_STREAM("\"\\uD800\"");
+    TEST_STREAM("\"\\uD800\\u");
+    TEST_STREAM("\"\\uD800\\uE000\"");
+    TEST_STREAM("\"\\uD800\\u12G4\"");
+    TEST_STREAM("{");
+    TEST_STREAM("{1:1}");
+    TEST_STREAM("{\"a\",1}");
+    TEST_STREAM("{\"a\":1 \"b\":2}");
+    TEST_STREAM("{\"a\":1,}");
+    TEST_STREAM("{\"a\":{\"b\":[1,{\"c\":\"d\"");
+    TEST_STREAM("{\"a\":1]");
+    TEST_STREAM("{\"a\":12}}");
+
+    /* the value is complete as soon as its last byte arrives */
+    lept_stream_init(&s, &v);
+    EXPECT_EQ_INT(LEPT_PARSE_NEED_MORE, lept_stream_feed(&s, "[1,", 3));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_stream_feed(&s, "2]", 2));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_stream_feed(&s, " ", 1));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_stream_finish(&s));
+    EXPECT_EQ_SIZE_T(2, lept_get_array_size(&v));
+    lept_stream_free(&s);
+    lept_free(&v);
+    /* but a number only at the end */
+    lept_stream_init(&s, &v);
+    EXPECT_EQ_INT(LEPT_PARSE_NEED_MORE, lept_stream_feed(&s, "12", 2));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_stream_finish(&s));
+    EXPECT_EQ_DOUBLE(12.0, lept_get_number(&v));
+    lept_stream_free(&s);
+    lept_free(&v);
+    /* errors stick */
+    lept_stream_init(&s, &v);
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_stream_feed(&s, "[\"a\"}", 5));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_stream_feed(&s, "]", 1));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_stream_finish(&s));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    lept_stream_free(&s);
+    /* giving up halfway frees what was built */
+    lept_stream_init(&s, &v);
+    EXPECT_EQ_INT(LEPT_PARSE_NEED_MORE, lept_stream_feed(&s, "{\"a\":[\"b\",{\"c\":\"d", 17));
+    lept_stream_free(&s);
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+}
+
+/* Writes SAX events as text, and stops after stop events when stop is not 0. */
+typedef struct {
+    char s[256];
+    size_t len;
+    int events, stop;
+}sax_trace;
+
+static int sax_append(sax_trace* t, const char* s, size_t len) {
+    if (t->len > 0)
+        t->s[t->len++] = ' ';
+    memcpy(t->s + t->len, s, len);
+    t->s[t->len += len] = '\0';
+    return ++t->events != t->stop;
+}
+
+static int sax_null(void* user) {
+    return sax_append((sax_trace*)user, "n", 1);
+}
+
+static int sax_bool(void* user, int b) {
+    return sax_append((sax_trace*)user, b ? "t" : "f", 1);
+}
+
+static int sax_number(void* user, const lept_value* n) {
+    char buf[32];
+    sprintf(buf, "%g", lept_get_number(n));
+    return sax_append((sax_trace*)user, buf, strlen(buf));
+}
+
+static int sax_string(void* user, const char* s, size_t len) {
+    char buf[64];
+    buf[0] = '"';
+    memcpy(buf + 1, s, len);
+    buf[len + 1] = '"';
+    return sax_append((sax_trace*)user, buf, len + 2);
+}
+
+static int sax_key(void* user, const char* k, size_t klen) {
+    char buf[64];
+    memcpy(buf, k, klen);
+    buf[klen] = ':';
+    return sax_append((sax_trace*)user, buf, klen + 1);
+}
+
+static int sax_start_object(void* user) {
+    return sax_append((sax_trace*)user, "{", 1);
+}
+
+static int sax_end_object(void* user, size_t size) {
+    char buf[32];
+    sprintf(buf, "}%lu", (unsigned long)size);
+    return sax_append((sax_trace*)user, buf, strlen(buf));
+}
+
+static int sax_start_array(void* user) {
+    return sax_append((sax_trace*)user, "[", 1);
+}
+
+static int sax_end_array(void* user, size_t size) {
+    char buf[32];
+    sprintf(buf, "]%lu", (unsigned long)size);
+    return sax_append((sax_trace*)user, buf, strlen(buf));
+}
+
+#define TEST_SAX(expect_ret, expect, stop_after, json)\
+    do {\
+        lept_handler h = { sax_null, sax_bool, sax_number, sax_string,\
+            sax_start_object, sax_key, sax_end_object, sax_start_array, sax_end_array, NULL };\
+        sax_trace t;\
+        t.len = 0;\
+        t.s[0] = '\0';\
+        t.events = 0;\
+        t.stop = stop_after;\
+        h.user = &t;\
+        EXPECT_EQ_INT(expect_ret, lept_parse_sax(&h, json));\
+        EXPECT_EQ_STRING(expect, t.s, t.len);\
+    } while(0)
+
+static void test_parse_sax() {
+    static const char* errors[] = {
+        "", " ", "nul", "?", "+1", "1.", "1e309", "null x", "[1,]", "[1 2]", "[\"a\"",
+        "\"abc", "\"\\v\"", "\"\x01\"", "\"\\u12\"", "\"\\uD800\"", "{", "{1:1}", "{\"a\",1}",
+        "{\"a\":1 \"b\":2}", "{\"a\":1,}", "{\"a\":1]"
+    };
+    lept_handler empty = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+    lept_value v;
+    size_t i;
+
+    TEST_SAX(LEPT_PARSE_OK, "n", 0, "null");
+    TEST_SAX(LEPT_PARSE_OK, "t", 0, " true ");
+    TEST_SAX(LEPT_PARSE_OK, "-1.5", 0, "-1.5e0");
+    TEST_SAX(LEPT_PARSE_OK, "\"a\nb\"", 0, "\"a\\nb\"");
+    TEST_SAX(LEPT_PARSE_OK, "[ ]0", 0, "[ ]");
+    TEST_SAX(LEPT_PARSE_OK, "{ }0", 0, "{ }");
+    TEST_SAX(LEPT_PARSE_OK, "[ n f t 123 \"abc\" [ 1 2 3 ]3 ]6", 0,
+        "[ null , false , true , 123 , \"abc\", [ 1, 2, 3 ] ]");
+    TEST_SAX(LEPT_PARSE_OK, "{ n: n a: [ 1 ]1 o: { \"k\": \"\" }1 }3", 0,
+        " { \"n\" : null , \"a\" : [ 1 ], \"o\" : { \"\\\"k\\\"\" : \"\" } } ");
+
+    /* errors come after the events before them */
+    TEST_SAX(LEPT_PARSE_ROOT_NOT_SINGULAR, "n", 0, "null x");
+    TEST_SAX(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[ 1", 0, "[1}");
+    TEST_SAX(LEPT_PARSE_INVALID_VALUE, "{ a: [ 1", 0, "{\"a\":[1,?]}");
+
+    /* a callback can stop the parse */
+    TEST_SAX(LEPT_PARSE_ABORTED, "[ n f", 3, "[ null , false , true ]");
+    TEST_SAX(LEPT_PARSE_ABORTED, "{ a:", 2, "{\"a\":1}");
+    TEST_SAX(LEPT_PARSE_ABORTED, "[ ]0", 2, "[]");
+
+    /* without callbacks it only validates, with the errors of lept_parse() */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_sax(&empty, "{\"a\":[1,2,{\"b\":null}],\"c\":\"\\u20AC\"}"));
+    for (i = 0; i < sizeof(errors) / sizeof(errors[0]); i++) {
+        lept_init(&v);
+        EXPECT_EQ_INT(lept_parse(&v, errors[i]), lept_parse_sax(&empty, errors[i]));
+        lept_free(&v);
+    }
+}
+
+/* n arrays nested in each other, or objects when key is set */
+static char* nested(size_t n, int key) {
+    char* json = (char*)malloc(n * 6 + 1), *p = json;
+    size_t i;
+    for (i = 0; i < n; i++)
+        if (key) {
+            memcpy(p, "{\"a\":", 5);
+            p += 5;
+        }
+        else
+            *p++ = '[';
+    for (i = 0; i < n; i++)
+        *p++ = key ? '}' : ']';
+    *p = '\0';
+    return json;
+}
+
+static void test_parse_depth() {
+    lept_handler empty = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+    char* json = nested(LEPT_PARSER_MAX_DEPTH, 0), *deep = nested(LEPT_PARSER_MAX_DEPTH + 1, 1);
+    lept_parser p;
+    lept_stream s;
+    lept_value v;
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(&v));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parse(&v, deep));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_sax(&empty, json));
+    EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parse_sax(&empty, deep));
+    lept_stream_init(&s, &v);
+    EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_stream_feed(&s, deep, strlen(deep)));
+    lept_stream_free(&s);
+    free(json);
+    free(deep);
+
+    lept_parser_init(&p);
+    p.max_depth = 2;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, "[{\"a\":1},[]]"));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parser_parse(&p, &v, "[{\"a\":[]}]"));
+    EXPECT_EQ_INT(LEPT_PARSE_DEPTH_EXCEEDED, lept_parser_parse(&p, &v, "[1,[2,{}],\"x\"]"));
+    /* nesting only costs parse stack */
+    p.max_depth = 100000;
+    json = nested(100000, 0);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, json));
+    free(json);
+    lept_free(&v);
+    lept_parser_free(&p);
+}
+
 static void test_parse() {
     test_parse_null();
     test_parse_true();
     test_parse_false();
     test_parse_number();
+    test_parse_integer();
     test_parse_string();
     test_parse_array();
     test_parse_object();
@@ -367,6 +825,11 @@ static void test_parse() {
     test_parse_miss_key();
     test_parse_miss_colon();
     test_parse_miss_comma_or_curly_bracket();
+    test_parse_indexed();
+    test_parse_n();
+    test_parse_stream();
+    test_parse_sax();
+    test_parse_depth();
 }
 
 #define TEST_ROUNDTRIP(json)\
@@ -393,18 +856,65 @@ static void test_stringify_number() {
     TEST_ROUNDTRIP("1e+20");
     TEST_ROUNDTRIP("1.234e+20");
     TEST_ROUNDTRIP("1.234e-20");
+    TEST_ROUNDTRIP("0.1");
+    TEST_ROUNDTRIP("0.30000000000000004"); /* 0.1 + 0.2 */
+    TEST_ROUNDTRIP("0.0001");
+    TEST_ROUNDTRIP("1e-05");
+    TEST_ROUNDTRIP("123.456");
+    TEST_ROUNDTRIP("9007199254740992"); /* 2^53 */
+    TEST_ROUNDTRIP("-9007199254740992");
+    TEST_ROUNDTRIP("10000000000000000");
+    TEST_ROUNDTRIP("1e+17");
+    TEST_ROUNDTRIP("1.2345678901234568e+17");
 
     TEST_ROUNDTRIP("1.0000000000000002"); /* the smallest number > 1 */
-    TEST_ROUNDTRIP("4.9406564584124654e-324"); /* minimum denormal */
-    TEST_ROUNDTRIP("-4.9406564584124654e-324");
-    TEST_ROUNDTRIP("2.2250738585072009e-308");  /* Max subnormal double */
-    TEST_ROUNDTRIP("-2.2250738585072009e-308");
+    TEST_ROUNDTRIP("5e-324"); /* minimum denormal */
+    TEST_ROUNDTRIP("-5e-324");
+    TEST_ROUNDTRIP("2.225073858507201e-308");  /* Max subnormal double */
+    TEST_ROUNDTRIP("-2.225073858507201e-308");
     TEST_ROUNDTRIP("2.2250738585072014e-308");  /* Min normal positive double */
     TEST_ROUNDTRIP("-2.2250738585072014e-308");
     TEST_ROUNDTRIP("1.7976931348623157e+308");  /* Max double */
     TEST_ROUNDTRIP("-1.7976931348623157e+308");
 }
 
+static void test_stringify_integer() {
+    TEST_ROUNDTRIP("9007199254740993");
+    TEST_ROUNDTRIP("9223372036854775807");
+    TEST_ROUNDTRIP("-9223372036854775808");
+    TEST_ROUNDTRIP("18446744073709551615");
+    TEST_ROUNDTRIP("1.8446744073709552e+19"); /* 2^64 stays a double */
+}
+
+static void test_stringify_whole_double() {
+    lept_value v1, v2;
+    char* json;
+    size_t i, length;
+    double d;
+    /* whole doubles past 2^53 must not read back as the nearby integer literal */
+    TEST_ROUNDTRIP("9.007199254740992e+15");
+    TEST_ROUNDTRIP("9.007199254740994e+15");
+    TEST_ROUNDTRIP("1e+16");
+    TEST_ROUNDTRIP("5.059695505392357e+16");
+    TEST_ROUNDTRIP("-5.059695505392357e+16");
+    lept_init(&v1);
+    lept_init(&v2);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v1, "50596955053923570.39"));
+    json = lept_stringify(&v1, &length);
+    EXPECT_EQ_STRING("5.059695505392357e+16", json, length);
+    free(json);
+    for (i = 0, d = 9007199254740992.0; i < 300; i++, d = d * 1.02 + 2.0) {
+        lept_set_number(&v1, (double)(int64_t)d);
+        json = lept_stringify(&v1, &length);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_n(&v2, json, length));
+        EXPECT_TRUE(lept_is_equal(&v1, &v2));
+        EXPECT_TRUE(lept_hash(&v1) == lept_hash(&v2));
+        free(json);
+    }
+    lept_free(&v1);
+    lept_free(&v2);
+}
+
 static void test_stringify_string() {
     TEST_ROUNDTRIP("\"\"");
     TEST_ROUNDTRIP("\"Hello\"");
@@ -428,6 +938,8 @@ static void test_stringify() {
     TEST_ROUNDTRIP("false");
     TEST_ROUNDTRIP("true");
     test_stringify_number();
+    test_stringify_integer();
+    test_stringify_whole_double();
     test_stringify_string();
     test_stringify_array();
     test_stringify_object();
@@ -441,6 +953,7 @@ static void test_stringify() {
         EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v1, json1));\
         EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v2, json2));\
         EXPECT_EQ_INT(equality, lept_is_equal(&v1, &v2));\
+        EXPECT_EQ_INT(equality, lept_hash(&v1) == lept_hash(&v2));\
         lept_free(&v1);\
         lept_free(&v2);\
     } while(0)
@@ -453,6 +966,12 @@ static void test_equal() {
     TEST_EQUAL("null", "0", 0);
     TEST_EQUAL("123", "123", 1);
     TEST_EQUAL("123", "456", 0);
+    TEST_EQUAL("1", "1.0", 1);
+    TEST_EQUAL("-1", "-1e0", 1);
+    TEST_EQUAL("0", "-0", 1);
+    TEST_EQUAL("9007199254740993", "9007199254740992.0", 0);
+    TEST_EQUAL("9223372036854775808", "9223372036854775808.0", 1);
+    TEST_EQUAL("18446744073709551615", "18446744073709551616", 0);
     TEST_EQUAL("\"abc\"", "\"abc\"", 1);
     TEST_EQUAL("\"abc\"", "\"abcd\"", 0);
     TEST_EQUAL("[]", "[]", 1);
@@ -469,6 +988,56 @@ static void test_equal() {
     TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"a\":1,\"b\":2,\"c\":3}", 0);
     TEST_EQUAL("{\"a\":{\"b\":{\"c\":{}}}}", "{\"a\":{\"b\":{\"c\":{}}}}", 1);
     TEST_EQUAL("{\"a\":{\"b\":{\"c\":{}}}}", "{\"a\":{\"b\":{\"c\":[]}}}", 0);
+    TEST_EQUAL("{\"a\":1,\"a\":2}", "{\"a\":1,\"a\":2}", 1);
+    TEST_EQUAL("{\"b\":0,\"a\":1,\"a\":2}", "{\"a\":1,\"b\":0,\"a\":2}", 1);
+    TEST_EQUAL("{\"a\":1,\"a\":1}", "{\"a\":1,\"b\":1}", 0);
+    TEST_EQUAL("{\"b\":1,\"a\":1}", "{\"a\":1,\"a\":1}", 0);
+    TEST_EQUAL("{\"b\":0,\"c\":0,\"a\":1,\"a\":1}", "{\"a\":1,\"a\":1,\"b\":0,\"c\":0}", 1);
+    TEST_EQUAL("{\"a\":[1],\"a\":[2]}", "{\"a\":[2],\"a\":[1]}", 1);
+    TEST_EQUAL("{\"a\":[1],\"a\":[1]}", "{\"a\":[1],\"a\":[2]}", 0);
+    TEST_EQUAL("{\"a\":{\"x\":1,\"x\":2},\"a\":0}", "{\"a\":0,\"a\":{\"x\":2,\"x\":1}}", 1);
+}
+
+/* Wide objects compare in any order through their tables. */
+static void test_equal_wide() {
+    lept_value v1, v2;
+    char key[32];
+    size_t i, n = 1000;
+    lept_init(&v1);
+    lept_init(&v2);
+    lept_set_object(&v1, 0);
+    lept_set_object(&v2, 0);
+    for (i = 0; i < n; i++) {
+        sprintf(key, "k%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(&v1, key, strlen(key)), (double)i);
+        sprintf(key, "k%lu", (unsigned long)(n - 1 - i));
+        lept_set_number(lept_set_object_value(&v2, key, strlen(key)), (double)(n - 1 - i));
+    }
+    EXPECT_TRUE(lept_is_equal(&v1, &v2));
+    EXPECT_TRUE(lept_is_equal(&v2, &v1));
+    lept_set_number(lept_find_object_value(&v2, "k500", 4), -1.0);
+    EXPECT_FALSE(lept_is_equal(&v1, &v2));
+    lept_set_number(lept_find_object_value(&v2, "k500", 4), 500.0);
+    lept_remove_object_value(&v2, lept_find_object_index(&v2, "k7", 2));
+    lept_set_number(lept_set_object_value(&v2, "k1000", 5), 7.0);
+    EXPECT_FALSE(lept_is_equal(&v1, &v2));
+    lept_free(&v1);
+    lept_free(&v2);
+
+    /* hashed objects whose repeated keys come in another order */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v1,
+        "{\"b\":0,\"c\":0,\"d\":0,\"e\":0,\"f\":0,\"g\":0,\"h\":0,\"i\":0,"
+        "\"j\":0,\"k\":0,\"l\":0,\"m\":0,\"n\":0,\"o\":0,\"a\":1,\"a\":1,\"a\":[2],\"a\":[3]}"));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v2,
+        "{\"a\":[3],\"a\":1,\"a\":[2],\"a\":1,\"b\":0,\"c\":0,\"d\":0,\"e\":0,"
+        "\"f\":0,\"g\":0,\"h\":0,\"i\":0,\"j\":0,\"k\":0,\"l\":0,\"m\":0,\"n\":0,\"o\":0}"));
+    EXPECT_TRUE(lept_is_equal(&v1, &v2));
+    EXPECT_TRUE(lept_is_equal(&v2, &v1));
+    lept_set_number(lept_get_array_element(lept_get_object_value(&v2, 2), 0), 3.0);
+    EXPECT_FALSE(lept_is_equal(&v1, &v2));
+    EXPECT_FALSE(lept_is_equal(&v2, &v1));
+    lept_free(&v1);
+    lept_free(&v2);
 }
 
 static void test_copy() {
@@ -510,6 +1079,150 @@ static void test_swap() {
     lept_free(&v2);
 }
 
+static void test_layout() {
+#ifdef LEPT_COMPACT_VALUE
+    lept_value v;
+    EXPECT_EQ_SIZE_T(16, sizeof(lept_value));
+    lept_init(&v);
+    lept_set_array(&v, (size_t)1 << 20);
+    EXPECT_EQ_SIZE_T((size_t)1 << 20, lept_get_array_capacity(&v));
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(&v));
+    lept_free(&v);
+#endif
+    EXPECT_TRUE(sizeof(lept_value) <= 4 * sizeof(void*));
+}
+
+/* Alternating arrays and objects n deep around a string, returning the string. */
+static lept_value* deepen(lept_value* v, size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++)
+        if (i % 2) {
+            lept_set_object(v, 0);
+            v = lept_set_object_value(v, "a", 1);
+        }
+        else {
+            lept_set_array(v, 0);
+            v = lept_pushback_array_element(v);
+        }
+    lept_set_string(v, "leaf", 4);
+    return v;
+}
+
+/* n objects that each repeat key "a" around leaf, the nested member last, or first when swapped. */
+static char* repeated(size_t n, int swapped, const char* leaf) {
+    const char* open = swapped ? "{\"a\":" : "{\"a\":0,\"a\":", *close = swapped ? ",\"a\":0}" : "}";
+    char* json = (char*)malloc(n * 12 + strlen(leaf) + 1), *p = json;
+    size_t i;
+    for (i = 0; i < n; i++, p += strlen(open))
+        memcpy(p, open, strlen(open));
+    strcpy(p, leaf);
+    p += strlen(leaf);
+    for (i = 0; i < n; i++, p += strlen(close))
+        memcpy(p, close, strlen(close));
+    *p = '\0';
+    return json;
+}
+
+static void test_deep() {
+    lept_value v1, v2, *leaf;
+    lept_parser p;
+    char key[8], *json;
+    size_t i, length;
+    lept_init(&v1);
+    lept_init(&v2);
+    lept_parser_init(&p);
+    deepen(&v1, 1000000);
+    lept_copy(&v2, &v1);
+    EXPECT_TRUE(lept_is_equal(&v1, &v2));
+    lept_free(&v2);
+    p.max_depth = 1000001;
+    json = lept_stringify(&v1, &length);
+    EXPECT_EQ_SIZE_T(1000000 / 2 * 8 + 6, length);  /* 8 bytes every two levels, around "leaf" */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v2, json));
+    EXPECT_TRUE(lept_is_equal(&v1, &v2));
+    free(json);
+    lept_free(&v2);
+    leaf = deepen(&v2, 1000000);
+    lept_set_string(leaf, "leaves", 6);
+    EXPECT_FALSE(lept_is_equal(&v1, &v2));
+    lept_free(&v1);
+    lept_free(&v2);
+
+    /* a hashed object whose members are containers */
+    lept_set_object(&v1, 0);
+    for (i = 0; i < 100; i++) {
+        sprintf(key, "k%u", (unsigned)i);
+        deepen(lept_set_object_value(&v1, key, strlen(key)), i % 5);
+    }
+    lept_copy(&v2, &v1);
+    EXPECT_TRUE(lept_is_equal(&v2, &v1));
+    EXPECT_EQ_SIZE_T(100, lept_get_object_size(&v2));
+    EXPECT_TRUE(lept_find_object_value(&v2, "k99", 3) != NULL);
+    lept_set_null(lept_find_object_value(&v2, "k42", 3));
+    EXPECT_FALSE(lept_is_equal(&v2, &v1));
+    lept_free(&v1);
+    lept_free(&v2);
+
+    /* a repeated key in another order at every level, each match a trial of its own */
+    p.max_depth = 100001;
+    json = repeated(100000, 0, "1");
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v1, json));
+    free(json);
+    json = repeated(100000, 1, "1");
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v2, json));
+    free(json);
+    EXPECT_TRUE(lept_is_equal(&v1, &v2));
+    EXPECT_TRUE(lept_is_equal(&v2, &v1));
+    lept_free(&v2);
+    json = repeated(100000, 1, "2");
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v2, json));
+    free(json);
+    EXPECT_FALSE(lept_is_equal(&v1, &v2));
+    EXPECT_FALSE(lept_is_equal(&v2, &v1));
+    lept_free(&v1);
+    lept_free(&v2);
+    lept_parser_free(&p);
+}
+
+/* Every string length around the hash lanes, and trees too deep to recurse. */
+static void test_hash() {
+    lept_value v1, v2, *e;
+    char s[100];
+    size_t i;
+    uint64_t h;
+    lept_init(&v1);
+    lept_init(&v2);
+    for (i = 0; i < sizeof(s); i++)
+        s[i] = (char)('a' + i % 26);
+    for (i = 0; i < sizeof(s); i++) {
+        lept_set_string(&v1, s, i);
+        lept_copy(&v2, &v1);
+        EXPECT_TRUE(lept_hash(&v1) == lept_hash(&v2));
+        if (i > 0) {
+            s[i - 1] ^= 1;
+            lept_set_string(&v2, s, i);
+            s[i - 1] ^= 1;
+            EXPECT_TRUE(lept_hash(&v1) != lept_hash(&v2));
+        }
+        lept_set_string(&v2, s, i + 1);
+        EXPECT_TRUE(lept_hash(&v1) != lept_hash(&v2));
+    }
+    lept_set_number(&v1, 0.0);
+    lept_set_number(&v2, -0.0);
+    EXPECT_TRUE(lept_hash(&v1) == lept_hash(&v2));
+    lept_set_number(&v2, 0.5);
+    EXPECT_TRUE(lept_hash(&v1) != lept_hash(&v2));
+
+    deepen(&v1, 1000000);
+    h = lept_hash(&v1);
+    e = deepen(&v2, 1000000);
+    EXPECT_TRUE(h == lept_hash(&v2));
+    lept_set_string(e, "leaf!", 5);
+    EXPECT_TRUE(h != lept_hash(&v2));
+    lept_free(&v1);
+    lept_free(&v2);
+}
+
 static void test_access_null() {
     lept_value v;
     lept_init(&v);
@@ -536,6 +1249,65 @@ static void test_access_number() {
     lept_set_string(&v, "a", 1);
     lept_set_number(&v, 1234.5);
     EXPECT_EQ_DOUBLE(1234.5, lept_get_number(&v));
+    EXPECT_EQ_INT(LEPT_NUMBER_DOUBLE, lept_get_number_kind(&v));
+    lept_free(&v);
+}
+
+static void test_access_int64() {
+    lept_value v, u;
+    lept_init(&v);
+    lept_init(&u);
+    lept_set_string(&v, "a", 1);
+    lept_set_int64(&v, INT64_MIN);
+    EXPECT_EQ_INT(LEPT_NUMBER_INT64, lept_get_number_kind(&v));
+    EXPECT_TRUE(lept_get_int64(&v) == INT64_MIN);
+    lept_set_uint64(&v, UINT64_MAX);
+    EXPECT_EQ_INT(LEPT_NUMBER_UINT64, lept_get_number_kind(&v));
+    EXPECT_TRUE(lept_get_uint64(&v) == UINT64_MAX);
+    lept_set_uint64(&v, 42);
+    lept_set_int64(&u, 42);
+    EXPECT_EQ_DOUBLE(42.0, lept_get_number(&v));
+    EXPECT_TRUE(lept_is_equal(&u, &v));
+    lept_free(&v);
+    lept_free(&u);
+}
+
+/* Reading a number the result cannot hold saturates. */
+static void test_access_int64_range() {
+    lept_value v;
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "1e20"));
+    EXPECT_TRUE(lept_get_int64(&v) == INT64_MAX);
+    EXPECT_TRUE(lept_get_uint64(&v) == UINT64_MAX);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "-1e20"));
+    EXPECT_TRUE(lept_get_int64(&v) == INT64_MIN);
+    EXPECT_TRUE(lept_get_uint64(&v) == 0);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "-1.0"));
+    EXPECT_TRUE(lept_get_int64(&v) == -1);
+    EXPECT_TRUE(lept_get_uint64(&v) == 0);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "-0.5"));
+    EXPECT_TRUE(lept_get_int64(&v) == 0);
+    EXPECT_TRUE(lept_get_uint64(&v) == 0);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "18446744073709551616"));   /* 2^64, a double */
+    EXPECT_TRUE(lept_get_uint64(&v) == UINT64_MAX);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "18446744073709549568.0")); /* the largest double below 2^64 */
+    EXPECT_TRUE(lept_get_uint64(&v) == UINT64_C(18446744073709549568));
+    EXPECT_TRUE(lept_get_int64(&v) == INT64_MAX);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "9223372036854775808.0"));  /* 2^63 */
+    EXPECT_TRUE(lept_get_int64(&v) == INT64_MAX);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "-9223372036854775808.0"));
+    EXPECT_TRUE(lept_get_int64(&v) == INT64_MIN);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "-9223372036854777856.0")); /* the next double down */
+    EXPECT_TRUE(lept_get_int64(&v) == INT64_MIN);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "9223372036854775808"));    /* UINT64 */
+    EXPECT_TRUE(lept_get_int64(&v) == INT64_MAX);
+    EXPECT_TRUE(lept_get_uint64(&v) == UINT64_C(9223372036854775808));
+    lept_set_int64(&v, -1);
+    EXPECT_TRUE(lept_get_uint64(&v) == 0);
+    lept_set_number(&v, 0.0);
+    lept_set_number(&v, lept_get_number(&v) / lept_get_number(&v));   /* NaN */
+    EXPECT_TRUE(lept_get_int64(&v) == 0);
+    EXPECT_TRUE(lept_get_uint64(&v) == 0);
     lept_free(&v);
 }
 
@@ -591,15 +1363,13 @@ static void test_access_array() {
     for (i = 0; i < 6; i++)
         EXPECT_EQ_DOUBLE((double)i + 2, lept_get_number(lept_get_array_element(&a, i)));
 
-#if 0
     for (i = 0; i < 2; i++) {
         lept_init(&e);
         lept_set_number(&e, i);
         lept_move(lept_insert_array_element(&a, i), &e);
         lept_free(&e);
     }
-#endif
-    
+
     EXPECT_EQ_SIZE_T(8, lept_get_array_size(&a));
     for (i = 0; i < 8; i++)
         EXPECT_EQ_DOUBLE((double)i, lept_get_number(lept_get_array_element(&a, i)));
@@ -625,8 +1395,72 @@ static void test_access_array() {
     lept_free(&a);
 }
 
+static void test_access_array_range() {
+    lept_value a, b, c, *e;
+    size_t i;
+    lept_init(&a);
+    lept_init(&b);
+    lept_init(&c);
+
+    /* one reserve for the whole range, with room to grow */
+    lept_set_array(&a, 0);
+    e = lept_insert_array_elements(&a, 0, 100);
+    EXPECT_EQ_SIZE_T(100, lept_get_array_size(&a));
+    EXPECT_EQ_SIZE_T(100, lept_get_array_capacity(&a));
+    for (i = 0; i < 100; i++) {
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&e[i]));
+        lept_set_number(&e[i], (double)i);
+    }
+    EXPECT_TRUE(lept_insert_array_elements(&a, 50, 0) == NULL);
+    e = lept_insert_array_elements(&a, 50, 3);
+    EXPECT_EQ_SIZE_T(103, lept_get_array_size(&a));
+    EXPECT_EQ_SIZE_T(200, lept_get_array_capacity(&a));
+    for (i = 0; i < 3; i++)
+        lept_set_string(&e[i], "a string long enough for the heap", 33);
+    EXPECT_EQ_DOUBLE(49.0, lept_get_number(lept_get_array_element(&a, 49)));
+    EXPECT_EQ_DOUBLE(50.0, lept_get_number(lept_get_array_element(&a, 53)));
+    EXPECT_EQ_DOUBLE(99.0, lept_get_number(lept_get_array_element(&a, 102)));
+    lept_erase_array_element(&a, 49, 5);
+    EXPECT_EQ_SIZE_T(98, lept_get_array_size(&a));
+    for (i = 0; i < 98; i++)
+        EXPECT_EQ_DOUBLE((double)(i < 49 ? i : i + 2), lept_get_number(lept_get_array_element(&a, i)));
+
+    /* spliced elements move, strings and all */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&b, "[\"a string long enough for the heap\",[1,2],{\"k\":true}]"));
+    lept_splice_array(&a, 1, &b);
+    EXPECT_EQ_SIZE_T(101, lept_get_array_size(&a));
+    EXPECT_EQ_SIZE_T(0, lept_get_array_size(&b));
+    EXPECT_EQ_STRING("a string long enough for the heap", lept_get_string(lept_get_array_element(&a, 1)), 33);
+    EXPECT_EQ_SIZE_T(2, lept_get_array_size(lept_get_array_element(&a, 2)));
+    EXPECT_EQ_DOUBLE(1.0, lept_get_number(lept_get_array_element(&a, 4)));
+    lept_set_number(lept_pushback_array_element(&b), 7.0);
+    lept_free(&b);
+
+    /* from shared storage: the source keeps its own */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&b, "[\"another string long enough for the heap\",{}]"));
+    lept_share(&c, &b);
+    lept_splice_array(&a, lept_get_array_size(&a), &c);
+    EXPECT_EQ_SIZE_T(0, lept_get_array_size(&c));
+    EXPECT_EQ_SIZE_T(2, lept_get_array_size(&b));
+    EXPECT_TRUE(lept_get_string(lept_get_array_element(&a, 101)) == lept_get_string(lept_get_array_element(&b, 0)));
+    lept_free(&c);
+    lept_free(&b);
+    EXPECT_EQ_STRING("another string long enough for the heap", lept_get_string(lept_get_array_element(&a, 101)), 39);
+    lept_erase_array_element(&a, 0, lept_get_array_size(&a));
+    EXPECT_EQ_SIZE_T(0, lept_get_array_size(&a));
+    lept_free(&a);
+
+    /* into the array that holds src, which has to grow */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&a, "[1,[2,\"a string long enough for the heap\"],4]"));
+    EXPECT_EQ_SIZE_T(3, lept_get_array_capacity(&a));
+    lept_splice_array(&a, 0, lept_get_array_element(&a, 1));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&b, "[2,\"a string long enough for the heap\",1,[],4]"));
+    EXPECT_TRUE(lept_is_equal(&a, &b));
+    lept_free(&a);
+    lept_free(&b);
+}
+
 static void test_access_object() {
-#if 0
     lept_value o, v, *pv;
     size_t i, j, index;
 
@@ -695,16 +1529,689 @@ static void test_access_object() {
     EXPECT_EQ_SIZE_T(0, lept_get_object_capacity(&o));
 
     lept_free(&o);
-#endif
+}
+
+static void test_access_object_wide() {
+    lept_value o, v;
+    size_t i, index;
+    char key[8];
+
+    lept_init(&o);
+    lept_set_object(&o, 0);
+    for (i = 0; i < 300; i++) {
+        sprintf(key, "k%u", (unsigned)i);
+        lept_init(&v);
+        lept_set_number(&v, (double)i);
+        lept_move(lept_set_object_value(&o, key, strlen(key)), &v);
+    }
+    EXPECT_EQ_SIZE_T(300, lept_get_object_size(&o));
+    lept_set_number(lept_set_object_value(&o, "k7", 2), 7.5); /* existing key: no new member */
+    EXPECT_EQ_SIZE_T(300, lept_get_object_size(&o));
+
+    lept_remove_object_value(&o, lept_find_object_index(&o, "k0", 2));
+    lept_remove_object_value(&o, lept_find_object_index(&o, "k150", 4));
+    EXPECT_EQ_SIZE_T(298, lept_get_object_size(&o));
+    EXPECT_TRUE(lept_find_object_value(&o, "k0", 2) == NULL);
+    EXPECT_TRUE(lept_find_object_value(&o, "k150", 4) == NULL);
+    EXPECT_TRUE(lept_find_object_value(&o, "k300", 4) == NULL);
+    EXPECT_EQ_DOUBLE(7.5, lept_get_number(lept_find_object_value(&o, "k7", 2)));
+    for (i = 1; i < 300; i++) {
+        if (i == 7 || i == 150)
+            continue;
+        sprintf(key, "k%u", (unsigned)i);
+        index = lept_find_object_index(&o, key, strlen(key));
+        EXPECT_EQ_SIZE_T(i < 150 ? i - 1 : i - 2, index);     /* insertion order is kept */
+        EXPECT_EQ_DOUBLE((double)i, lept_get_number(lept_get_object_value(&o, index)));
+    }
+
+    lept_shrink_object(&o);
+    EXPECT_EQ_SIZE_T(298, lept_get_object_capacity(&o));
+    EXPECT_EQ_DOUBLE(299.0, lept_get_number(lept_find_object_value(&o, "k299", 4)));
+    lept_clear_object(&o);
+    EXPECT_TRUE(lept_find_object_value(&o, "k1", 2) == NULL);
+    lept_free(&o);
+
+    /* parsed objects are indexed too, and the first of duplicate keys wins */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&o,
+        "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,"
+        "\"i\":9,\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,\"p\":16,\"a\":17}"));
+    EXPECT_EQ_SIZE_T(17, lept_get_object_size(&o));
+    EXPECT_EQ_SIZE_T(0, lept_find_object_index(&o, "a", 1));
+    EXPECT_EQ_SIZE_T(15, lept_find_object_index(&o, "p", 1));
+    EXPECT_TRUE(lept_find_object_value(&o, "q", 1) == NULL);
+    lept_free(&o);
+}
+
+static void test_access_object_remove() {
+    lept_value o, v, s;
+    unsigned keys[200];
+    size_t i, j, n, index;
+    char key[8];
+
+    /* both removals keep every other member findable at its new index */
+    lept_init(&o);
+    lept_set_object(&o, 0);
+    for (i = 0; i < 200; i++) {
+        sprintf(key, "k%u", (unsigned)i);
+        lept_set_number(lept_set_object_value(&o, key, strlen(key)), (double)i);
+        keys[i] = (unsigned)i;
+    }
+    for (n = 200, j = 0; n > 0; j++) {
+        index = (j * 37) % n;
+        if (j % 2 == 0) {
+            lept_remove_object_value(&o, index);
+            memmove(&keys[index], &keys[index + 1], (n - index - 1) * sizeof(unsigned));
+        }
+        else {
+            lept_swap_remove_object_value(&o, index);
+            keys[index] = keys[n - 1];
+        }
+        EXPECT_EQ_SIZE_T(--n, lept_get_object_size(&o));
+        if (j % 16 != 0 && n > 0)
+            continue;
+        for (i = 0; i < n; i++) {
+            sprintf(key, "k%u", keys[i]);
+            EXPECT_EQ_SIZE_T(i, lept_find_object_index(&o, key, strlen(key)));
+            EXPECT_EQ_DOUBLE((double)keys[i], lept_get_number(lept_get_object_value(&o, i)));
+        }
+    }
+    EXPECT_TRUE(lept_find_object_value(&o, "k0", 2) == NULL);
+    lept_set_number(lept_set_object_value(&o, "k0", 2), 0.0);
+    EXPECT_EQ_SIZE_T(0, lept_find_object_index(&o, "k0", 2));
+    lept_free(&o);
+
+    /* with a duplicate key, removing the first of them uncovers the other */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&o,
+        "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,"
+        "\"i\":9,\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,\"p\":16,\"a\":17}"));
+    lept_swap_remove_object_value(&o, 0);
+    EXPECT_EQ_SIZE_T(0, lept_find_object_index(&o, "a", 1));
+    EXPECT_EQ_DOUBLE(17.0, lept_get_number(lept_find_object_value(&o, "a", 1)));
+    lept_remove_object_value(&o, 0);
+    EXPECT_TRUE(lept_find_object_value(&o, "a", 1) == NULL);
+    EXPECT_EQ_SIZE_T(14, lept_find_object_index(&o, "p", 1));
+    lept_remove_object_value(&o, lept_find_object_index(&o, "h", 1));
+    EXPECT_EQ_SIZE_T(13, lept_find_object_index(&o, "p", 1));
+    lept_free(&o);
+
+    /* removal from shared storage leaves the other owner whole */
+    lept_init(&v);
+    lept_set_object(&v, 0);
+    for (i = 0; i < 20; i++) {
+        sprintf(key, "k%u", (unsigned)i);
+        lept_set_number(lept_set_object_value(&v, key, strlen(key)), (double)i);
+    }
+    lept_init(&s);
+    lept_share(&s, &v);
+    lept_swap_remove_object_value(&s, 3);
+    lept_remove_object_value(&s, 0);
+    EXPECT_EQ_SIZE_T(18, lept_get_object_size(&s));
+    EXPECT_EQ_SIZE_T(20, lept_get_object_size(&v));
+    EXPECT_EQ_SIZE_T(2, lept_find_object_index(&s, "k19", 3));
+    EXPECT_TRUE(lept_find_object_value(&s, "k3", 2) == NULL);
+    EXPECT_EQ_SIZE_T(3, lept_find_object_index(&v, "k3", 2));
+    lept_free(&s);
+    lept_free(&v);
 }
 
 static void test_access() {
     test_access_null();
     test_access_boolean();
     test_access_number();
+    test_access_int64();
+    test_access_int64_range();
     test_access_string();
     test_access_array();
+    test_access_array_range();
     test_access_object();
+    test_access_object_wide();
+    test_access_object_remove();
+}
+
+#define TEST_DOCUMENT(json)\
+    do {\
+        lept_document d;\
+        lept_value v;\
+        char* json2, *insitu = NULL;\
+        size_t length;\
+        int mode;\
+        for (mode = 0; mode < 3; mode++) {\
+            lept_document_init(&d);\
+            d.views = mode == 1;\
+            lept_init(&v);\
+            if (mode == 2) {\
+                insitu = (char*)malloc(sizeof(json));\
+                memcpy(insitu, json, sizeof(json));\
+                EXPECT_EQ_INT(LEPT_PARSE_OK, lept_document_parse_insitu(&d, insitu));\
+            }\
+            else\
+                EXPECT_EQ_INT(LEPT_PARSE_OK, lept_document_parse(&d, json));\
+            EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
+            EXPECT_TRUE(lept_is_equal(&d.root, &v));\
+            json2 = lept_stringify(&d.root, &length);\
+            EXPECT_EQ_STRING(json, json2, length);\
+            free(json2);\
+            lept_free(&v);\
+            lept_document_free(&d);\
+        }\
+        free(insitu);\
+    } while(0)
+
+static void test_document() {
+    lept_document d;
+    lept_value v;
+    const lept_value* e;
+    char json[8192], *p = json;
+    size_t i;
+
+    TEST_DOCUMENT("null");
+    TEST_DOCUMENT("\"Hello\\nWorld\"");
+    TEST_DOCUMENT("[null,false,true,123,\"abc\",[1,2,3]]");
+    TEST_DOCUMENT("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
+
+    /* enough members to spill into several chunks and to index the object */
+    p += sprintf(p, "{");
+    for (i = 0; i < 200; i++)
+        p += sprintf(p, "%s\"key%u\":[%u,\"value %u\"]", i > 0 ? "," : "", (unsigned)i, (unsigned)i, (unsigned)i);
+    sprintf(p, "}");
+    lept_document_init(&d);
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_document_parse(&d, json));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    EXPECT_TRUE(lept_is_equal(&d.root, &v));
+    lept_free(&v);
+    EXPECT_TRUE(d.chunks != NULL);
+    EXPECT_EQ_SIZE_T(200, lept_get_object_size(&d.root));
+    e = lept_find_object_value(&d.root, "key123", 6);
+    EXPECT_TRUE(e != NULL && lept_get_type(e) == LEPT_ARRAY);
+    EXPECT_EQ_DOUBLE(123.0, lept_get_number(lept_get_array_element((lept_value*)e, 0)));
+
+    /* values are copied out to be changed */
+    lept_init(&v);
+    lept_copy(&v, lept_get_array_element((lept_value*)e, 1));
+    EXPECT_EQ_STRING("value 123", lept_get_string(&v), lept_get_string_length(&v));
+    lept_set_string(&v, "changed", 7);
+    lept_copy(&v, lept_get_array_element((lept_value*)e, 0));
+    lept_set_number(&v, 1.0);
+    lept_free(&v);
+
+    /* parsing again replaces the content; on error the document is left empty */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_document_parse(&d, "[\"a\",\"b\"]"));
+    EXPECT_EQ_SIZE_T(2, lept_get_array_size(&d.root));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_document_parse(&d, "{\"a\":[\"b\",{}]"));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&d.root));
+    EXPECT_EQ_INT(LEPT_PARSE_ROOT_NOT_SINGULAR, lept_document_parse(&d, "[\"a\"] x"));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&d.root));
+    EXPECT_TRUE(d.chunks == NULL);
+    lept_document_free(&d);
+}
+
+static void test_document_views() {
+    static const char json[] = "{\"plain\":\"abc\",\"esc\\u0061ped\":\"a\\tb\",\"\":[\"\",\"x\\\"y\"]}";
+    lept_document d;
+    lept_value v;
+    const lept_value* e;
+    const char* s;
+    lept_document_init(&d);
+    d.views = 1;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_document_parse(&d, json));
+    EXPECT_EQ_SIZE_T(3, lept_get_object_size(&d.root));
+
+    /* escape-free strings and keys stay in the input */
+    EXPECT_TRUE(lept_get_object_key(&d.root, 0) == json + 2);
+    s = lept_get_string(lept_get_object_value(&d.root, 0));
+    EXPECT_TRUE(s == strstr(json, "abc"));
+    EXPECT_EQ_SIZE_T(3, lept_get_string_length(lept_get_object_value(&d.root, 0)));
+    EXPECT_TRUE(lept_get_object_key(&d.root, 2) == strstr(json, "\"\":") + 1);
+    EXPECT_EQ_SIZE_T(0, lept_get_object_key_length(&d.root, 2));
+
+    /* the others are decoded */
+    EXPECT_EQ_STRING("escaped", lept_get_object_key(&d.root, 1), lept_get_object_key_length(&d.root, 1));
+    EXPECT_EQ_STRING("a\tb", lept_get_string(lept_get_object_value(&d.root, 1)), lept_get_string_length(lept_get_object_value(&d.root, 1)));
+    e = lept_get_array_element(lept_get_object_value(&d.root, 2), 1);
+    EXPECT_EQ_STRING("x\"y", lept_get_string(e), lept_get_string_length(e));
+    EXPECT_TRUE(lept_find_object_value(&d.root, "escaped", 7) != NULL);
+
+    /* a copy owns its strings */
+    lept_init(&v);
+    lept_copy(&v, lept_get_object_value(&d.root, 0));
+    EXPECT_TRUE(lept_get_string(&v) != s);
+    EXPECT_EQ_STRING("abc", lept_get_string(&v), lept_get_string_length(&v));
+    EXPECT_EQ_INT('\0', lept_get_string(&v)[3]);
+    lept_free(&v);
+
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_STRING_CHAR, lept_document_parse(&d, "[\"a\",\"b\x01\"]"));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&d.root));
+    lept_document_free(&d);
+}
+
+static void test_document_insitu() {
+    char json[] = "{\"plain\":\"abc\",\"esc\\u0061ped\":\"a\\tb\\uD834\\uDD1E\",\"\":[\"\",\"x\\\"y\"]}";
+    char bad[] = "[\"a\\n\",\"b\\x\"]";
+    lept_document d;
+    lept_value* e;
+    lept_document_init(&d);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_document_parse_insitu(&d, json));
+    EXPECT_EQ_SIZE_T(3, lept_get_object_size(&d.root));
+
+    /* every string lives in the input, decoded and null-terminated */
+    EXPECT_TRUE(lept_get_object_key(&d.root, 0) == json + 2);
+    EXPECT_EQ_STRING("plain", lept_get_object_key(&d.root, 0), lept_get_object_key_length(&d.root, 0));
+    e = lept_get_object_value(&d.root, 0);
+    EXPECT_TRUE(lept_get_string(e) == json + 10);
+    EXPECT_EQ_STRING("abc", lept_get_string(e), lept_get_string_length(e));
+    EXPECT_TRUE(lept_get_object_key(&d.root, 1) == json + 16);
+    EXPECT_EQ_STRING("escaped", lept_get_object_key(&d.root, 1), lept_get_object_key_length(&d.root, 1));
+    e = lept_get_object_value(&d.root, 1);
+    EXPECT_TRUE(lept_get_string(e) > json && lept_get_string(e) < json + sizeof(json));
+    EXPECT_EQ_STRING("a\tb\xF0\x9D\x84\x9E", lept_get_string(e), lept_get_string_length(e));
+    EXPECT_EQ_STRING("", lept_get_object_key(&d.root, 2), lept_get_object_key_length(&d.root, 2));
+    e = lept_get_object_value(&d.root, 2);
+    EXPECT_EQ_STRING("", lept_get_string(lept_get_array_element(e, 0)), lept_get_string_length(lept_get_array_element(e, 0)));
+    EXPECT_EQ_STRING("x\"y", lept_get_string(lept_get_array_element(e, 1)), lept_get_string_length(lept_get_array_element(e, 1)));
+    EXPECT_TRUE(lept_find_object_value(&d.root, "escaped", 7) == lept_get_object_value(&d.root, 1));
+
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_STRING_ESCAPE, lept_document_parse_insitu(&d, bad));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&d.root));
+    lept_document_free(&d);
+}
+
+static void test_document_file() {
+    static const char json[] = "{\"name\":\"leptjson\",\"tags\":[\"a\\tb\",\"c\"],\"n\":1}";
+    static const char path[] = "lept_test.json";
+    lept_document d;
+    lept_value v;
+    const char* s;
+    FILE* f = fopen(path, "wb");
+    EXPECT_TRUE(f != NULL);
+    if (f == NULL)
+        return;
+    fwrite(json, 1, sizeof(json) - 1, f);
+    fclose(f);
+
+    lept_document_init(&d);
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_document_parse_file(&d, path));
+    EXPECT_TRUE(lept_is_equal(&d.root, &v));
+    EXPECT_TRUE(d.file == NULL);
+
+    /* views point into the mapping, which the document keeps */
+    d.views = 1;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_document_parse_file(&d, path));
+    EXPECT_TRUE(lept_is_equal(&d.root, &v));
+    EXPECT_TRUE(d.file != NULL);
+    EXPECT_EQ_SIZE_T(sizeof(json) - 1, d.file_size);
+    s = lept_get_string(lept_get_object_value(&d.root, 0));
+    EXPECT_TRUE(s == (const char*)d.file + 9);
+    lept_document_free(&d);
+    EXPECT_TRUE(d.file == NULL);
+    lept_free(&v);
+
+    EXPECT_EQ_INT(LEPT_PARSE_IO_ERROR, lept_document_parse_file(&d, "lept_test_missing.json"));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&d.root));
+    f = fopen(path, "wb");
+    fclose(f);
+    EXPECT_EQ_INT(LEPT_PARSE_EXPECT_VALUE, lept_document_parse_file(&d, path));
+    EXPECT_TRUE(d.file == NULL);
+    lept_document_free(&d);
+    remove(path);
+}
+
+/* Counts live bytes, and checks the sizes given back against a header in front of each block. */
+typedef struct {
+    size_t live, blocks, mallocs, bad_sizes;
+}counting;
+
+#define COUNTING_HEADER 16
+
+static void* counting_malloc(void* user, size_t size) {
+    counting* c = (counting*)user;
+    char* p = (char*)malloc(size + COUNTING_HEADER);
+    memcpy(p, &size, sizeof(size));
+    c->live += size;
+    c->blocks++;
+    c->mallocs++;
+    return p + COUNTING_HEADER;
+}
+
+static void counting_free(void* user, void* ptr, size_t size) {
+    counting* c = (counting*)user;
+    size_t recorded;
+    if (ptr == NULL)
+        return;
+    memcpy(&recorded, (char*)ptr - COUNTING_HEADER, sizeof(recorded));
+    c->bad_sizes += recorded != size;
+    c->live -= recorded;
+    c->blocks--;
+    free((char*)ptr - COUNTING_HEADER);
+}
+
+static void* counting_realloc(void* user, void* ptr, size_t old_size, size_t size) {
+    void* p = counting_malloc(user, size);
+    if (ptr != NULL)
+        memcpy(p, ptr, old_size < size ? old_size : size);
+    counting_free(user, ptr, old_size);
+    return p;
+}
+
+/* Points a at the counting hooks, with count zeroed. */
+static void counting_allocator_init(lept_allocator* a, counting* count) {
+    memset(count, 0, sizeof(counting));
+    a->malloc_fn = counting_malloc;
+    a->realloc_fn = counting_realloc;
+    a->free_fn = counting_free;
+    a->user = count;
+}
+
+static void test_allocator() {
+    counting count;
+    lept_allocator a;
+    lept_document d;
+    lept_value v, *e;
+    char* json;
+    size_t length;
+    counting_allocator_init(&a, &count);
+
+    lept_set_allocator(&a);
+    EXPECT_TRUE(lept_get_allocator()->user == &count);
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"a\":[1,\"two\",{\"3\":null}],\"b\":\"\\u00e9\"}"));
+    EXPECT_TRUE(count.blocks > 0);
+    e = lept_find_object_value(&v, "a", 1);
+    lept_set_string(lept_pushback_array_element(e), "four", 4);
+    lept_shrink_array(e);
+    lept_set_number(lept_set_object_value(&v, "c", 1), 5.0);
+    lept_remove_object_value(&v, lept_find_object_index(&v, "b", 1));
+    json = lept_stringify_with(&v, &length, &a);
+    EXPECT_EQ_STRING("{\"a\":[1,\"two\",{\"3\":null},\"four\"],\"c\":5}", json, length);
+    counting_free(&count, json, length + 1);
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_indexed(&v, "[\"x\",{\"y\":[2]}]"));
+    lept_free(&v);
+    lept_set_allocator(NULL);
+    EXPECT_EQ_SIZE_T(0, count.live);
+    EXPECT_EQ_SIZE_T(0, count.blocks);
+    EXPECT_EQ_SIZE_T(0, count.bad_sizes);
+    EXPECT_TRUE(lept_get_allocator()->user == NULL);
+
+    /* a document can bring its own */
+    lept_document_init(&d);
+    d.allocator = &a;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_document_parse(&d, "[\"a\",[\"b\",\"c\"],{\"d\":\"e\"}]"));
+    EXPECT_TRUE(count.blocks > 0);
+    lept_document_free(&d);
+    EXPECT_EQ_SIZE_T(0, count.live);
+    EXPECT_EQ_SIZE_T(0, count.bad_sizes);
+}
+
+/* Short strings and keys take no allocation of their own; longer ones do. */
+static void test_allocator_short_strings() {
+    counting count;
+    lept_allocator a;
+    lept_value v, v2;
+    counting_allocator_init(&a, &count);
+    lept_set_allocator(&a);
+    lept_init(&v);
+    lept_init(&v2);
+
+    /* the object's members, the array's elements */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"id\":\"a1\",\"tags\":[\"x\",\"\\u00e9\"],\"\":\"\"}"));
+    EXPECT_EQ_SIZE_T(2, count.blocks);
+    EXPECT_EQ_STRING("\xC3\xA9", lept_get_string(lept_get_array_element(lept_find_object_value(&v, "tags", 4), 1)), 2);
+    EXPECT_EQ_STRING("", lept_get_object_key(&v, 2), 0);
+    lept_copy(&v2, &v);
+    EXPECT_EQ_SIZE_T(4, count.blocks);
+    EXPECT_TRUE(lept_is_equal(&v, &v2));
+    lept_free(&v2);
+
+    lept_set_string(&v, "0123456", 7);
+    EXPECT_EQ_SIZE_T(0, count.blocks);
+    EXPECT_EQ_STRING("0123456", lept_get_string(&v), 7);
+    lept_set_string(&v, "a string long enough for the heap", 33);
+    EXPECT_EQ_SIZE_T(1, count.blocks);
+    EXPECT_EQ_STRING("a string long enough for the heap", lept_get_string(&v), 33);
+    lept_set_object(&v, 2);
+    lept_set_number(lept_set_object_value(&v, "key", 3), 1.0);
+    lept_set_number(lept_set_object_value(&v, "a key long enough for the heap", 30), 2.0);
+    EXPECT_EQ_SIZE_T(2, count.blocks);
+    EXPECT_EQ_STRING("key", lept_get_object_key(&v, 0), 3);
+    EXPECT_EQ_STRING("a key long enough for the heap", lept_get_object_key(&v, 1), 30);
+    EXPECT_EQ_INT('\0', lept_get_object_key(&v, 0)[3]);
+    EXPECT_EQ_SIZE_T(1, lept_find_object_index(&v, "a key long enough for the heap", 30));
+    lept_free(&v);
+    lept_set_allocator(NULL);
+    EXPECT_EQ_SIZE_T(0, count.live);
+    EXPECT_EQ_SIZE_T(0, count.bad_sizes);
+}
+
+/* Long keys parsed through a pool are shared between values; short ones stay inline. */
+static void test_intern() {
+    static const char json[] = "{\"a_rather_long_key\":[{\"a_rather_long_key\":1}],\"id\":2}";
+    counting count;
+    lept_allocator a;
+    lept_intern* t;
+    lept_parser p;
+    lept_document d;
+    lept_value v, v2;
+    const char* key;
+    char buf[32];
+    const char* keys[100];
+    size_t i;
+    counting_allocator_init(&a, &count);
+    t = lept_intern_new(&a);
+    lept_parser_init(&p);
+    p.intern = t;
+    lept_init(&v);
+    lept_init(&v2);
+
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, json));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v2, json));
+    EXPECT_EQ_SIZE_T(1, lept_intern_count(t));
+    key = lept_intern_key(t, "a_rather_long_key", 17);
+    EXPECT_EQ_STRING("a_rather_long_key", key, 17);
+    EXPECT_TRUE(lept_get_object_key(&v, 0) == key);
+    EXPECT_TRUE(lept_get_object_key(&v2, 0) == key);
+    EXPECT_TRUE(lept_get_object_key(lept_get_array_element(lept_get_object_value(&v, 0), 0), 0) == key);
+    EXPECT_EQ_STRING("id", lept_get_object_key(&v, 1), 2);
+    EXPECT_EQ_SIZE_T(0, lept_find_object_index(&v, key, 17));
+    EXPECT_EQ_SIZE_T(0, lept_find_object_index(&v, "a_rather_long_key", 17));
+    EXPECT_TRUE(lept_is_equal(&v, &v2));
+    lept_free(&v2);
+
+    /* copies share pooled keys, new keys are their own */
+    lept_copy(&v2, &v);
+    EXPECT_TRUE(lept_get_object_key(&v2, 0) == key);
+    lept_set_null(lept_set_object_value(&v2, "a key that is not pooled", 24));
+    EXPECT_EQ_SIZE_T(1, lept_intern_count(t));
+    lept_remove_object_value(&v2, 0);
+    lept_free(&v2);
+    lept_free(&v);
+
+    lept_document_init(&d);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_document(&p, &d, json));
+    EXPECT_TRUE(lept_get_object_key(&d.root, 0) == key);
+    lept_document_free(&d);
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_parser_parse(&p, &v, "{\"another_long_key_name\":[1}"));
+    EXPECT_EQ_SIZE_T(2, lept_intern_count(t));
+
+    for (i = 0; i < 100; i++) {
+        sprintf(buf, "key_%lu", (unsigned long)i);
+        keys[i] = lept_intern_key(t, buf, strlen(buf));
+    }
+    EXPECT_EQ_SIZE_T(102, lept_intern_count(t));
+    for (i = 0; i < 100; i++) {
+        sprintf(buf, "key_%lu", (unsigned long)i);
+        EXPECT_TRUE(lept_intern_key(t, buf, strlen(buf)) == keys[i]);
+    }
+    EXPECT_TRUE(lept_intern_key(t, "", 0) != NULL);
+
+    /* a new pool is not served the keys the parser remembers from the old one, whatever its address */
+    lept_intern_free(t);
+    p.intern = t = lept_intern_new(&a);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, json));
+    EXPECT_EQ_SIZE_T(1, lept_intern_count(t));
+    EXPECT_TRUE(lept_get_object_key(&v, 0) == lept_intern_key(t, "a_rather_long_key", 17));
+    lept_free(&v);
+    lept_parser_free(&p);
+    EXPECT_TRUE(count.blocks > 0);
+    lept_intern_free(t);
+    EXPECT_EQ_SIZE_T(0, count.live);
+    EXPECT_EQ_SIZE_T(0, count.bad_sizes);
+}
+
+/* A document copy lives in one allocation of exactly its size. */
+static void test_document_copy() {
+    counting count;
+    lept_allocator a;
+    lept_document d;
+    lept_value v, v2;
+    char key[32];
+    size_t i;
+    counting_allocator_init(&a, &count);
+    lept_init(&v);
+    lept_init(&v2);
+    lept_document_init(&d);
+    d.allocator = &a;
+
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"n\":[1,true,null,\"s\",[],{}],"
+        "\"a key long enough for the heap\":\"a string long enough for the heap\",\"o\":{\"x\":{\"y\":[-2]}}}"));
+    for (i = 0; i < 20; i++) {
+        sprintf(key, "member_%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(lept_find_object_value(&v, "o", 1), key, strlen(key)), (double)i);
+    }
+    lept_document_copy(&d, &v);
+    EXPECT_EQ_SIZE_T(1, count.blocks);
+    EXPECT_TRUE(lept_is_equal(&v, &d.root));
+    EXPECT_EQ_STRING("a string long enough for the heap",
+        lept_get_string(lept_find_object_value(&d.root, "a key long enough for the heap", 30)), 33);
+    EXPECT_EQ_DOUBLE(19.0, lept_get_number(lept_find_object_value(lept_find_object_value(&d.root, "o", 1), "member_19", 9)));
+    lept_copy(&v2, &d.root);
+    EXPECT_TRUE(lept_is_equal(&v, &v2));
+    lept_set_null(lept_set_object_value(&v2, "added", 5));
+    EXPECT_FALSE(lept_is_equal(&v, &v2));
+    lept_free(&v2);
+
+    /* a scalar needs no arena, and the copy replaces what d held */
+    lept_set_number(&v, 3.0);
+    lept_document_copy(&d, &v);
+    EXPECT_EQ_SIZE_T(0, count.blocks);
+    EXPECT_EQ_DOUBLE(3.0, lept_get_number(&d.root));
+    lept_set_string(&v, "short", 5);
+    lept_document_copy(&d, &v);
+    EXPECT_EQ_STRING("short", lept_get_string(&d.root), 5);
+    lept_free(&v);
+    lept_document_free(&d);
+    EXPECT_EQ_SIZE_T(0, count.live);
+    EXPECT_EQ_SIZE_T(0, count.bad_sizes);
+}
+
+/* Shared values copy on write, down the path that changes. */
+static void test_share() {
+    counting count;
+    lept_allocator a;
+    lept_value v, v2, v3;
+    const char* s;
+    size_t mallocs;
+    counting_allocator_init(&a, &count);
+    lept_set_allocator(&a);
+    lept_init(&v);
+    lept_init(&v2);
+    lept_init(&v3);
+
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"a\":[1,2,{\"b\":\"a string long enough for the heap\"}],"
+        "\"c\":\"another string long enough for the heap\",\"d\":[],\"e\":{}}"));
+    lept_share(&v2, &v);
+    mallocs = count.mallocs;
+    lept_share(&v3, &v);
+    EXPECT_EQ_SIZE_T(mallocs, count.mallocs);
+    EXPECT_TRUE(lept_is_equal(&v, &v2));
+    lept_free(&v3);
+
+    /* only the path to the change is copied */
+    lept_set_number(lept_pushback_array_element(lept_find_object_value(&v2, "a", 1)), 3.0);
+    EXPECT_EQ_SIZE_T(3, lept_get_array_size(lept_find_object_value(&v, "a", 1)));
+    EXPECT_EQ_SIZE_T(4, lept_get_array_size(lept_find_object_value(&v2, "a", 1)));
+    s = lept_get_string(lept_find_object_value(&v, "c", 1));
+    EXPECT_TRUE(lept_get_string(lept_find_object_value(&v2, "c", 1)) == s);
+    s = lept_get_string(lept_find_object_value(lept_get_array_element(lept_find_object_value(&v, "a", 1), 2), "b", 1));
+    EXPECT_TRUE(lept_get_string(lept_find_object_value(lept_get_array_element(lept_find_object_value(&v2, "a", 1), 2), "b", 1)) == s);
+    EXPECT_FALSE(lept_is_equal(&v, &v2));
+    lept_set_string(lept_find_object_value(&v2, "c", 1), "changed", 7);
+    EXPECT_EQ_STRING("another string long enough for the heap", lept_get_string(lept_find_object_value(&v, "c", 1)), 39);
+
+    /* the last holder changes in place; copies are deep */
+    lept_free(&v);
+    lept_remove_object_value(&v2, lept_find_object_index(&v2, "d", 1));
+    lept_set_null(lept_set_object_value(lept_find_object_value(&v2, "e", 1), "f", 1));
+    lept_copy(&v, &v2);
+    EXPECT_TRUE(lept_is_equal(&v, &v2));
+    lept_free(&v2);
+    EXPECT_EQ_STRING("a string long enough for the heap",
+        lept_get_string(lept_find_object_value(lept_get_array_element(lept_find_object_value(&v, "a", 1), 2), "b", 1)), 33);
+    lept_free(&v);
+
+    lept_set_string(&v, "a string long enough for the heap", 33);
+    lept_share(&v2, &v);
+    EXPECT_TRUE(lept_get_string(&v2) == lept_get_string(&v));
+    lept_free(&v);
+    EXPECT_EQ_STRING("a string long enough for the heap", lept_get_string(&v2), 33);
+    lept_set_number(&v, 1.0);
+    lept_share(&v2, &v);
+    EXPECT_EQ_DOUBLE(1.0, lept_get_number(&v2));
+    lept_free(&v2);
+    lept_set_allocator(NULL);
+    EXPECT_EQ_SIZE_T(0, count.live);
+    EXPECT_EQ_SIZE_T(0, count.bad_sizes);
+}
+
+static void test_parser() {
+    counting count;
+    lept_allocator a;
+    lept_parser p;
+    lept_document d;
+    lept_value v;
+    size_t mallocs = 0;
+    int i;
+    counting_allocator_init(&a, &count);
+
+    /* the parser allocator only holds the parser's own buffers, which are reused */
+    lept_parser_init(&p);
+    p.allocator = &a;
+    lept_init(&v);
+    for (i = 0; i < 3; i++) {
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse(&p, &v, "{\"a\":[1,\"two\",{\"3\":null}],\"b\":\"\\u00e9\"}"));
+        EXPECT_EQ_SIZE_T(2, lept_get_object_size(&v));
+        lept_free(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_indexed(&p, &v, "[\"x\",{\"y\":[2]}]"));
+        EXPECT_EQ_SIZE_T(2, lept_get_array_size(&v));
+        EXPECT_EQ_STRING("x", lept_get_string(lept_get_array_element(&v, 0)), lept_get_string_length(lept_get_array_element(&v, 0)));
+        lept_free(&v);
+        if (i == 0)
+            mallocs = count.mallocs;
+    }
+    EXPECT_TRUE(count.blocks > 0);
+    EXPECT_EQ_SIZE_T(mallocs, count.mallocs);
+
+    /* an error leaves the parser usable */
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_parser_parse(&p, &v, "[1,\"a\""));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    lept_document_init(&d);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_document(&p, &d, "[\"a\",[\"b\",\"c\"]]"));
+    EXPECT_EQ_SIZE_T(2, lept_get_array_size(&d.root));
+    lept_document_free(&d);
+    EXPECT_EQ_SIZE_T(mallocs, count.mallocs);
+
+    /* nothing is kept beyond retain */
+    p.retain = 0;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parser_parse_indexed(&p, &v, "[\"x\",{\"y\":[2]}]"));
+    lept_free(&v);
+    EXPECT_TRUE(p.stack == NULL);
+    EXPECT_TRUE(p.index == NULL);
+    EXPECT_EQ_SIZE_T(0, count.live);
+    lept_parser_free(&p);
+    EXPECT_EQ_SIZE_T(0, count.blocks);
+    EXPECT_EQ_SIZE_T(0, count.bad_sizes);
 }
 
 int main() {
@@ -714,10 +2221,24 @@ int main() {
     test_parse();
     test_stringify();
     test_equal();
+    test_equal_wide();
     test_copy();
     test_move();
     test_swap();
+    test_deep();
+    test_hash();
+    test_layout();
     test_access();
+    test_document();
+    test_document_views();
+    test_document_insitu();
+    test_document_file();
+    test_allocator();
+    test_allocator_short_strings();
+    test_intern();
+    test_document_copy();
+    test_share();
+    test_parser();
     printf("%d/%d (%3.2f%%) passed\n", test_pass, test_count, test_pass * 100.0 / test_count);
     return main_ret;
 }